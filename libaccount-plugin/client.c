@@ -32,25 +32,604 @@
 #include "client.h"
 #include "plugin.h"
 
+#include <glib/gstdio.h>
 #include <gmodule.h>
 #include <libaccounts-glib/ag-manager.h>
 #include <libaccounts-glib/ag-provider.h>
+#include <string.h>
 
+/* Keep this in sync with tools/update-plugin-manifest.c */
+#define PLUGIN_MANIFEST_HEADER "libaccount-plugin manifest 1"
+#define PLUGIN_MANIFEST_SUFFIX ".manifest"
+
+/* Minimum interval between two checks for changes in a plugin directory. */
+#define PLUGIN_DIR_CHECK_INTERVAL G_USEC_PER_SEC
+
+/* Index of the plugins available in a plugin directory. */
+typedef struct
+{
+    GHashTable *names;
+    gint64 mtime;
+    gint64 last_check;
+    guint generation;
+} PluginIndex;
+
+/* Process-wide registry of the account plugin types resolved so far, keyed
+ * by plugin name. Loading a plugin module is expensive and, since the modules
+ * are made resident, the GType they register can be reused for the whole
+ * lifetime of the process. A value of G_TYPE_INVALID records a plugin which
+ * could not be loaded. */
+static GHashTable *plugin_types = NULL;
+static guint plugin_types_generation = 0;
+
+/* Plugin indexes, keyed by plugin directory. Each rebuild of an index gets a
+ * new generation number, unique across all the indexes. */
+static GHashTable *plugin_indexes = NULL;
+static guint plugin_indexes_generation = 0;
+
+/* Names of the applications known to have no plugin, and the generation of
+ * the application plugin index they were computed from. Most applications
+ * have no plugin, and they are all looked up whenever an account is shown. */
+static GHashTable *missing_application_plugins = NULL;
+static guint missing_application_plugins_generation = 0;
+static guint missing_application_plugins_hits = 0;
+static guint missing_application_plugins_misses = 0;
+
+/* Protects the plugin registry and the plugin indexes, which are also
+ * accessed from the worker threads of the asynchronous loading functions. */
+G_LOCK_DEFINE_STATIC (plugin_registry);
+
+typedef struct
+{
+    gchar *plugin_dir;
+    gchar *plugin_name;
+    AgAccount *account;
+    AgApplication *application;
+    GType object_type;
+} LoadPluginData;
+
+static void
+plugin_index_free (PluginIndex *index)
+{
+    g_hash_table_unref (index->names);
+    g_slice_free (PluginIndex, index);
+}
+
+/* Get the modification time of @path, in nanoseconds, or -1 if it doesn't
+ * exist. Whole seconds are not enough, as a plugin can be installed in the
+ * same second as the manifest is written. */
+static gint64
+get_mtime (const gchar *path)
+{
+    GStatBuf buf;
+
+    if (g_stat (path, &buf) != 0)
+        return -1;
+
+    return (gint64) buf.st_mtim.tv_sec * G_GINT64_CONSTANT (1000000000) +
+        buf.st_mtim.tv_nsec;
+}
+
+/* Reverse g_module_build_path(): get the plugin name out of a module file
+ * name. */
 static gchar *
-get_module_path (AgProvider *provider)
+get_plugin_name_from_filename (const gchar *filename)
+{
+    const gchar prefix[] = "lib";
+    const gchar suffix[] = "." G_MODULE_SUFFIX;
+    gssize length;
+
+    if (!g_str_has_prefix (filename, prefix) ||
+        !g_str_has_suffix (filename, suffix))
+        return NULL;
+
+    length = strlen (filename) - (sizeof (prefix) - 1) - (sizeof (suffix) - 1);
+    if (length <= 0)
+        return NULL;
+
+    return g_strndup (filename + sizeof (prefix) - 1, length);
+}
+
+static gboolean
+read_plugin_manifest (const gchar *manifest_path, GHashTable *names)
+{
+    GMappedFile *mapped;
+    const gchar *contents, *end, *line, *eol;
+    gsize header_length = sizeof (PLUGIN_MANIFEST_HEADER) - 1;
+
+    mapped = g_mapped_file_new (manifest_path, FALSE, NULL);
+    if (mapped == NULL)
+        return FALSE;
+
+    contents = g_mapped_file_get_contents (mapped);
+    end = contents + g_mapped_file_get_length (mapped);
+    if (G_UNLIKELY (contents == NULL ||
+                    (gsize) (end - contents) <= header_length ||
+                    strncmp (contents, PLUGIN_MANIFEST_HEADER,
+                             header_length) != 0 ||
+                    contents[header_length] != '\n'))
+    {
+        g_warning ("%s: %s is not a valid plugin manifest",
+                   G_STRFUNC, manifest_path);
+        g_mapped_file_unref (mapped);
+        return FALSE;
+    }
+
+    for (line = contents + header_length + 1; line < end; line = eol + 1)
+    {
+        eol = memchr (line, '\n', end - line);
+        if (eol == NULL)
+            eol = end;
+
+        if (eol > line)
+            g_hash_table_add (names, g_strndup (line, eol - line));
+    }
+
+    g_mapped_file_unref (mapped);
+    return TRUE;
+}
+
+static void
+scan_plugin_dir (const gchar *plugin_dir, GHashTable *names)
+{
+    GDir *dir;
+    const gchar *filename;
+
+    dir = g_dir_open (plugin_dir, 0, NULL);
+    if (dir == NULL)
+        return;
+
+    while ((filename = g_dir_read_name (dir)) != NULL)
+    {
+        gchar *plugin_name = get_plugin_name_from_filename (filename);
+        if (plugin_name != NULL)
+            g_hash_table_add (names, plugin_name);
+    }
+
+    g_dir_close (dir);
+}
+
+/* Get the index of the plugins installed in @plugin_dir. The index is read
+ * from the manifest generated by the update-plugin-manifest tool, or built by
+ * listing the directory if the manifest is missing or out of date; it is
+ * refreshed whenever the modification time of the directory changes.
+ * Must be called with the plugin_registry lock held. */
+static PluginIndex *
+get_plugin_index (const gchar *plugin_dir)
+{
+    PluginIndex *index;
+    gchar *manifest_path;
+    gint64 now, mtime;
+
+    if (plugin_indexes == NULL)
+    {
+        plugin_indexes =
+            g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                   (GDestroyNotify)plugin_index_free);
+    }
+
+    now = g_get_monotonic_time ();
+    index = g_hash_table_lookup (plugin_indexes, plugin_dir);
+    if (index != NULL && now - index->last_check < PLUGIN_DIR_CHECK_INTERVAL)
+        return index;
+
+    mtime = get_mtime (plugin_dir);
+    if (index != NULL && index->mtime == mtime)
+    {
+        index->last_check = now;
+        return index;
+    }
+
+    if (index == NULL)
+    {
+        index = g_slice_new0 (PluginIndex);
+        index->names = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, NULL);
+        g_hash_table_insert (plugin_indexes, g_strdup (plugin_dir), index);
+    }
+    else
+    {
+        g_hash_table_remove_all (index->names);
+    }
+
+    index->mtime = mtime;
+    index->last_check = now;
+    index->generation = ++plugin_indexes_generation;
+
+    /* A missing directory contains no plugins. */
+    if (mtime < 0)
+        return index;
+
+    manifest_path = g_strconcat (plugin_dir, PLUGIN_MANIFEST_SUFFIX, NULL);
+    /* If the directory and the manifest have the same modification time, the
+     * directory might have changed after the manifest was written, within
+     * the resolution of the file system timestamps. */
+    if (get_mtime (manifest_path) <= mtime ||
+        !read_plugin_manifest (manifest_path, index->names))
+    {
+        g_debug ("%s: no up-to-date manifest for %s", G_STRFUNC, plugin_dir);
+        g_hash_table_remove_all (index->names);
+        scan_plugin_dir (plugin_dir, index->names);
+    }
+    g_free (manifest_path);
+
+    return index;
+}
+
+/* Must be called with the plugin_registry lock held. */
+static gboolean
+drop_failed_plugin_type (gpointer key, gpointer value, gpointer user_data)
+{
+    return GPOINTER_TO_SIZE (value) == G_TYPE_INVALID;
+}
+
+static const gchar *
+get_plugin_name (AgProvider *provider)
 {
     const gchar *plugin_name;
-    const gchar *plugin_dir;
 
     plugin_name = ag_provider_get_plugin_name (provider);
     if (plugin_name == NULL)
         plugin_name = ag_provider_get_name (provider);
 
+    return plugin_name;
+}
+
+/**
+ * ap_client_get_provider_plugin_dir:
+ *
+ * Get the directory where the account plugins for providers are looked up.
+ * This is the value of the <code>AP_PROVIDER_PLUGIN_DIR</code> environment
+ * variable if it is set, or the system-wide plugin directory otherwise; it
+ * can be used to monitor the installation of new plugins.
+ *
+ * Returns: the path of the provider plugin directory.
+ */
+const gchar *
+ap_client_get_provider_plugin_dir (void)
+{
+    const gchar *plugin_dir;
+
     plugin_dir = g_getenv ("AP_PROVIDER_PLUGIN_DIR");
     if (plugin_dir == NULL)
         plugin_dir = LIBACCOUNT_PLUGIN_DIR "/providers";
 
-    return g_module_build_path (plugin_dir, plugin_name);
+    return plugin_dir;
+}
+
+/**
+ * ap_client_get_application_plugin_dir:
+ *
+ * Get the directory where the application plugins are looked up. This is the
+ * value of the <code>AP_APPLICATION_PLUGIN_DIR</code> environment variable if
+ * it is set, or the system-wide plugin directory otherwise.
+ *
+ * Returns: the path of the application plugin directory.
+ */
+const gchar *
+ap_client_get_application_plugin_dir (void)
+{
+    const gchar *plugin_dir;
+
+    plugin_dir = g_getenv ("AP_APPLICATION_PLUGIN_DIR");
+    if (plugin_dir == NULL)
+        plugin_dir = LIBACCOUNT_PLUGIN_DIR "/applications";
+
+    return plugin_dir;
+}
+
+/* Open the module at @module_path and return the GType it provides, or
+ * G_TYPE_INVALID if the module is missing or doesn't provide a subclass of
+ * @parent_type. */
+static GType
+load_module_object_type (const gchar *module_path, GType parent_type,
+                         gboolean warn_if_missing)
+{
+    GModule *module;
+    gboolean ok;
+    GType (*ap_module_get_object_type) (void);
+    GType object_type;
+
+    module = g_module_open (module_path, 0);
+    if (module == NULL)
+    {
+        if (warn_if_missing)
+        {
+            g_warning ("%s: module %s not found: %s", G_STRFUNC, module_path,
+                       g_module_error ());
+        }
+        return G_TYPE_INVALID;
+    }
+
+    ok = g_module_symbol (module, "ap_module_get_object_type",
+                          (gpointer *)&ap_module_get_object_type);
+    if (G_UNLIKELY (!ok || ap_module_get_object_type == NULL))
+    {
+        g_critical ("%s: module %s does not export ap_module_get_object_type",
+                    G_STRFUNC, module_path);
+        g_module_close (module);
+        return G_TYPE_INVALID;
+    }
+
+    /* Make sure that the module is not unloaded: the GType system doesn't
+     * support that. */
+    object_type = ap_module_get_object_type ();
+    g_module_make_resident (module);
+
+    if (G_UNLIKELY (!G_TYPE_IS_OBJECT (object_type)))
+    {
+        g_critical ("%s: module %s does not create a valid GObject",
+                    G_STRFUNC, module_path);
+        return G_TYPE_INVALID;
+    }
+
+    if (G_UNLIKELY (!g_type_is_a (object_type, parent_type)))
+    {
+        g_critical ("%s: module %s does not create a valid %s",
+                    G_STRFUNC, module_path, g_type_name (parent_type));
+        return G_TYPE_INVALID;
+    }
+
+    return object_type;
+}
+
+static gboolean
+plugin_index_contains (const gchar *plugin_dir, const gchar *plugin_name)
+{
+    PluginIndex *index;
+    gboolean found;
+
+    G_LOCK (plugin_registry);
+    index = get_plugin_index (plugin_dir);
+    found = g_hash_table_contains (index->names, plugin_name);
+    G_UNLOCK (plugin_registry);
+
+    return found;
+}
+
+/* Resolve the GType of the account plugin @plugin_name. This can be called
+ * from any thread. */
+static GType
+get_plugin_type (const gchar *plugin_dir, const gchar *plugin_name)
+{
+    PluginIndex *index;
+    gchar *module_path;
+    gpointer value;
+    gboolean found;
+    GType object_type;
+
+    G_LOCK (plugin_registry);
+    index = get_plugin_index (plugin_dir);
+
+    if (plugin_types == NULL)
+    {
+        plugin_types = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, NULL);
+    }
+    else if (plugin_types_generation != index->generation)
+    {
+        /* The plugin directory has changed: plugins which were missing might
+         * have been installed since. */
+        g_hash_table_foreach_remove (plugin_types, drop_failed_plugin_type,
+                                     NULL);
+    }
+    plugin_types_generation = index->generation;
+
+    if (g_hash_table_lookup_extended (plugin_types, plugin_name, NULL, &value))
+    {
+        G_UNLOCK (plugin_registry);
+        return (GType) GPOINTER_TO_SIZE (value);
+    }
+
+    found = g_hash_table_contains (index->names, plugin_name);
+    G_UNLOCK (plugin_registry);
+
+    /* Loading the module can take a while: don't block the other callers,
+     * which might be looking up plugins which are already loaded. */
+    module_path = g_module_build_path (plugin_dir, plugin_name);
+    if (found)
+    {
+        object_type = load_module_object_type (module_path, AP_TYPE_PLUGIN,
+                                               TRUE);
+    }
+    else
+    {
+        g_warning ("%s: module %s not found", G_STRFUNC, module_path);
+        object_type = G_TYPE_INVALID;
+    }
+    g_free (module_path);
+
+    G_LOCK (plugin_registry);
+    /* Another thread might have resolved the same plugin in the meantime. */
+    if (g_hash_table_lookup_extended (plugin_types, plugin_name, NULL, &value) &&
+        (GType) GPOINTER_TO_SIZE (value) != G_TYPE_INVALID)
+    {
+        object_type = (GType) GPOINTER_TO_SIZE (value);
+    }
+    else
+    {
+        g_hash_table_insert (plugin_types, g_strdup (plugin_name),
+                             GSIZE_TO_POINTER (object_type));
+    }
+    G_UNLOCK (plugin_registry);
+
+    return object_type;
+}
+
+/* Resolve the GType of the application plugin @plugin_name. This can be
+ * called from any thread. */
+static GType
+get_application_plugin_type (const gchar *plugin_dir,
+                             const gchar *plugin_name)
+{
+    PluginIndex *index;
+    gchar *module_path;
+    gboolean found;
+    GType object_type;
+
+    G_LOCK (plugin_registry);
+    index = get_plugin_index (plugin_dir);
+
+    if (missing_application_plugins == NULL)
+    {
+        missing_application_plugins =
+            g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    }
+    else if (missing_application_plugins_generation != index->generation)
+    {
+        /* The plugin directory has changed. */
+        g_hash_table_remove_all (missing_application_plugins);
+    }
+    missing_application_plugins_generation = index->generation;
+
+    if (g_hash_table_contains (missing_application_plugins, plugin_name))
+    {
+        missing_application_plugins_hits++;
+        G_UNLOCK (plugin_registry);
+        return G_TYPE_INVALID;
+    }
+    missing_application_plugins_misses++;
+
+    found = g_hash_table_contains (index->names, plugin_name);
+    G_UNLOCK (plugin_registry);
+
+    /* The absence of an application plugin is not an exceptional condition;
+     * therefore, do not emit any warning if the module is missing. The lock
+     * is not held while loading the module, as in get_plugin_type(). */
+    if (found)
+    {
+        module_path = g_module_build_path (plugin_dir, plugin_name);
+        object_type = load_module_object_type (module_path,
+                                               AP_TYPE_APPLICATION_PLUGIN,
+                                               FALSE);
+        g_free (module_path);
+    }
+    else
+    {
+        object_type = G_TYPE_INVALID;
+    }
+
+    if (object_type == G_TYPE_INVALID)
+    {
+        G_LOCK (plugin_registry);
+        g_hash_table_add (missing_application_plugins, g_strdup (plugin_name));
+        G_UNLOCK (plugin_registry);
+    }
+
+    return object_type;
+}
+
+/* The worker thread may drop the last reference to the task, so this must
+ * not release the account and the application: construct_plugin_cb() does
+ * that in the main context. */
+static void
+load_plugin_data_free (LoadPluginData *data)
+{
+    g_free (data->plugin_dir);
+    g_free (data->plugin_name);
+    g_slice_free (LoadPluginData, data);
+}
+
+/* Release the account and the application of @data in the main context of
+ * the caller, as AgAccount is not thread-safe. */
+static void
+load_plugin_data_release_objects (LoadPluginData *data)
+{
+    g_clear_object (&data->account);
+    if (data->application != NULL)
+    {
+        ag_application_unref (data->application);
+        data->application = NULL;
+    }
+}
+
+/* Runs in the main context of the caller: plugin objects are not
+ * thread-safe, and neither is the AgAccount they are created for. */
+static gboolean
+construct_plugin_cb (gpointer user_data)
+{
+    GTask *task = user_data;
+    LoadPluginData *data = g_task_get_task_data (task);
+    GObject *plugin = NULL;
+
+    if (g_task_return_error_if_cancelled (task))
+    {
+        load_plugin_data_release_objects (data);
+        return FALSE;
+    }
+
+    if (data->object_type == G_TYPE_INVALID)
+    {
+        /* not an error: the synchronous functions just return NULL */
+    }
+    else if (data->application != NULL)
+    {
+        plugin = g_object_new (data->object_type,
+                               "application", data->application,
+                               "account", data->account,
+                               NULL);
+    }
+    else
+    {
+        plugin = g_object_new (data->object_type,
+                               "account", data->account,
+                               NULL);
+    }
+    load_plugin_data_release_objects (data);
+
+    g_task_return_pointer (task, plugin, g_object_unref);
+    return FALSE;
+}
+
+static void
+load_plugin_thread (GTask *task, gpointer source_object, gpointer task_data,
+                    GCancellable *cancellable)
+{
+    LoadPluginData *data = task_data;
+    GSource *source;
+
+    if (data->application != NULL)
+        data->object_type = get_application_plugin_type (data->plugin_dir,
+                                                         data->plugin_name);
+    else
+        data->object_type = get_plugin_type (data->plugin_dir,
+                                             data->plugin_name);
+
+    /* Initialize the class here, rather than on the main thread. */
+    if (data->object_type != G_TYPE_INVALID)
+        g_type_class_unref (g_type_class_ref (data->object_type));
+
+    source = g_idle_source_new ();
+    g_task_attach_source (task, source, construct_plugin_cb);
+    g_source_unref (source);
+}
+
+static void
+load_plugin_in_thread (GTask *task, LoadPluginData *data)
+{
+    g_task_set_task_data (task, data, (GDestroyNotify)load_plugin_data_free);
+    g_task_run_in_thread (task, load_plugin_thread);
+    g_object_unref (task);
+}
+
+/* Complete @task without a plugin, in the cases where the synchronous
+ * functions return NULL. */
+static void
+return_no_plugin (GTask *task)
+{
+    g_task_return_pointer (task, NULL, NULL);
+    g_object_unref (task);
+}
+
+/* Complete @task with an error, in the cases where the synchronous functions
+ * fail a precondition check. */
+static void
+return_invalid_argument (GTask *task, const gchar *message)
+{
+    g_critical ("%s", message);
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                             "%s", message);
+    g_object_unref (task);
 }
 
 /**
@@ -58,6 +637,9 @@ get_module_path (AgProvider *provider)
  * @account: the #AgAccount to be created/edited.
  *
  * Load the account plugin for @account.
+ * The plugin type is resolved only the first time that a plugin is requested;
+ * subsequent calls for the same plugin (including those which failed) are
+ * served from a process-wide registry, see ap_client_lookup_plugin_type().
  *
  * Returns: (transfer full): a new #ApPlugin if a valid plugin was found, %NULL
  * otherwise.
@@ -66,13 +648,9 @@ ApPlugin *
 ap_client_load_plugin (AgAccount *account)
 {
     const gchar *provider_name;
-    gchar *module_path;
     AgManager *manager;
     AgProvider *provider;
-    GModule *module;
     ApPlugin *plugin = NULL;
-    gboolean ok;
-    GType (*ap_module_get_object_type) (void);
     GType object_type;
 
     g_return_val_if_fail (AG_IS_ACCOUNT (account), NULL);
@@ -90,53 +668,171 @@ ap_client_load_plugin (AgAccount *account)
     provider = ag_manager_get_provider (manager, provider_name);
     g_return_val_if_fail (provider != NULL, NULL);
 
-    module_path = get_module_path (provider);
-    module = g_module_open (module_path, 0);
-    if (G_UNLIKELY (module == NULL))
+    object_type = get_plugin_type (ap_client_get_provider_plugin_dir (),
+                                   get_plugin_name (provider));
+    if (object_type != G_TYPE_INVALID)
     {
-        g_warning ("%s: module %s not found: %s", G_STRFUNC, module_path,
-                   g_module_error ());
-        goto error;
+        plugin = g_object_new (object_type,
+                               "account", account,
+                               NULL);
     }
 
-    ok = g_module_symbol (module, "ap_module_get_object_type",
-                          (gpointer *)&ap_module_get_object_type);
-    if (G_UNLIKELY (!ok || ap_module_get_object_type == NULL))
+    ag_provider_unref (provider);
+    return plugin;
+}
+
+/**
+ * ap_client_load_plugin_async:
+ * @account: the #AgAccount to be created/edited.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @callback: a callback which will be invoked when the plugin has been
+ * loaded.
+ * @user_data: user data to be passed to the callback.
+ *
+ * Asynchronous version of ap_client_load_plugin(). The plugin module is
+ * loaded and its type initialized in a worker thread, while the plugin object
+ * is constructed in the thread-default main context of the caller. When the
+ * operation is finished, @callback will be invoked; you can then call
+ * ap_client_load_plugin_finish() to get the plugin.
+ */
+void
+ap_client_load_plugin_async (AgAccount *account,
+                             GCancellable *cancellable,
+                             GAsyncReadyCallback callback,
+                             gpointer user_data)
+{
+    const gchar *provider_name;
+    AgManager *manager;
+    AgProvider *provider;
+    LoadPluginData *data;
+    GTask *task;
+
+    /* The callback must be invoked on every path, or the caller would wait
+     * forever. */
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, ap_client_load_plugin_async);
+
+    if (G_UNLIKELY (!AG_IS_ACCOUNT (account)))
     {
-        g_critical ("%s: module %s does not export ap_module_get_object_type",
-                    G_STRFUNC, module_path);
-        g_module_close (module);
-        goto error;
+        return_invalid_argument (task, "ap_client_load_plugin_async: "
+                                 "invalid account");
+        return;
     }
 
-    object_type = ap_module_get_object_type ();
-    if (G_UNLIKELY (!G_TYPE_IS_OBJECT (object_type)))
+    provider_name = ag_account_get_provider_name (account);
+    if (G_UNLIKELY (provider_name == NULL))
     {
-        g_critical ("%s: module %s does not create a valid GObject",
-                    G_STRFUNC, module_path);
-        g_module_close (module);
-        goto error;
+        g_warning ("%s: account has no provider!", G_STRFUNC);
+        return_no_plugin (task);
+        return;
     }
 
-    plugin = g_object_new (object_type,
-                           "account", account,
-                           NULL);
-    if (G_UNLIKELY (!AP_IS_PLUGIN (plugin)))
+    manager = ag_account_get_manager (account);
+    if (G_UNLIKELY (!AG_IS_MANAGER (manager)))
     {
-        g_critical ("%s: module %s did not create a valid ApPlugin",
-                    G_STRFUNC, module_path);
-        g_module_close (module);
-        goto error;
+        return_invalid_argument (task, "ap_client_load_plugin_async: "
+                                 "account has no manager");
+        return;
     }
 
-    /* Make sure that the module is not unloaded: the GType system doesn't
-     * support that. */
-    g_module_make_resident (module);
+    provider = ag_manager_get_provider (manager, provider_name);
+    if (G_UNLIKELY (provider == NULL))
+    {
+        return_invalid_argument (task, "ap_client_load_plugin_async: "
+                                 "provider of the account not found");
+        return;
+    }
 
-error:
+    data = g_slice_new0 (LoadPluginData);
+    data->plugin_dir = g_strdup (ap_client_get_provider_plugin_dir ());
+    data->plugin_name = g_strdup (get_plugin_name (provider));
+    data->account = g_object_ref (account);
     ag_provider_unref (provider);
-    g_free (module_path);
-    return plugin;
+
+    load_plugin_in_thread (task, data);
+}
+
+/**
+ * ap_client_load_plugin_finish:
+ * @result: the #GAsyncResult obtained from the #GAsyncReadyCallback passed to
+ * ap_client_load_plugin_async().
+ * @error: location for error, or %NULL.
+ *
+ * Finishes the operation started with ap_client_load_plugin_async().
+ *
+ * Returns: (transfer full): a new #ApPlugin if a valid plugin was found,
+ * %NULL otherwise or if an error occurred.
+ */
+ApPlugin *
+ap_client_load_plugin_finish (GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+    g_return_val_if_fail (g_async_result_is_tagged (result,
+                                                    ap_client_load_plugin_async),
+                          NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * ap_client_lookup_plugin_type:
+ * @plugin_name: the name of the account plugin.
+ * @object_type: (out) (allow-none): location for the plugin #GType, or %NULL.
+ *
+ * Inspect the registry of account plugin types. If @plugin_name has already
+ * been requested by ap_client_load_plugin(), @object_type is set to the
+ * #GType of the plugin, or to %G_TYPE_INVALID if the plugin could not be
+ * loaded.
+ *
+ * Returns: %TRUE if @plugin_name is in the registry, %FALSE otherwise.
+ */
+gboolean
+ap_client_lookup_plugin_type (const gchar *plugin_name, GType *object_type)
+{
+    gpointer value;
+
+    gboolean found;
+
+    g_return_val_if_fail (plugin_name != NULL, FALSE);
+
+    G_LOCK (plugin_registry);
+    found = plugin_types != NULL &&
+        g_hash_table_lookup_extended (plugin_types, plugin_name,
+                                      NULL, &value);
+    G_UNLOCK (plugin_registry);
+
+    if (found && object_type != NULL)
+        *object_type = (GType) GPOINTER_TO_SIZE (value);
+    return found;
+}
+
+/**
+ * ap_client_invalidate_plugin_types:
+ * @plugin_name: (allow-none): the name of the account plugin, or %NULL.
+ *
+ * Remove @plugin_name from the registry of account plugin types, or clear the
+ * whole registry if @plugin_name is %NULL. The next call to
+ * ap_client_load_plugin() will look up the plugin module again; this is
+ * useful if a plugin has been installed after a failed lookup, or if the
+ * <code>AP_PROVIDER_PLUGIN_DIR</code> environment variable has changed.
+ */
+void
+ap_client_invalidate_plugin_types (const gchar *plugin_name)
+{
+    G_LOCK (plugin_registry);
+    if (plugin_types == NULL)
+    {
+        /* nothing to do */
+    }
+    else if (plugin_name != NULL)
+    {
+        g_hash_table_remove (plugin_types, plugin_name);
+    }
+    else
+    {
+        g_hash_table_remove_all (plugin_types);
+    }
+    G_UNLOCK (plugin_registry);
 }
 
 /**
@@ -145,22 +841,51 @@ error:
  *
  * Checks if there is a valid account plugin for creating accounts having
  * @provider as provider.
+ * The check is answered from the plugin manifest written by the
+ * update-plugin-manifest tool when plugins are installed, or from a listing
+ * of the plugin directory if the manifest is out of date; no file system
+ * access is needed as long as the plugin directory doesn't change.
  *
  * Returns: %TRUE if a plugin is found, %FALSE otherwise.
  */
 gboolean
 ap_client_has_plugin (AgProvider *provider)
 {
-    gchar *module_path;
-    gboolean exists;
+    g_return_val_if_fail (provider != NULL, FALSE);
+
+    return plugin_index_contains (ap_client_get_provider_plugin_dir (),
+                                  get_plugin_name (provider));
+}
+
+/**
+ * ap_client_has_application_plugin:
+ * @application: the #AgApplication.
+ *
+ * Checks if there is a valid application plugin for editing the @application
+ * specific settings of accounts, without creating it.
+ * The plugin module is looked up in the plugin manifest, and its #GType is
+ * resolved as by ap_client_load_application_plugin(); applications without
+ * a plugin are remembered until the application plugin directory changes.
+ * This function can be called from any thread.
+ *
+ * Returns: %TRUE if a plugin is found, %FALSE otherwise.
+ */
+gboolean
+ap_client_has_application_plugin (AgApplication *application)
+{
+    const gchar *application_name;
+
+    g_return_val_if_fail (application != NULL, FALSE);
 
-    module_path = get_module_path (provider);
-    if (!module_path)
+    application_name = ag_application_get_name (application);
+    if (G_UNLIKELY (application_name == NULL))
+    {
+        g_warning ("%s: application has no name!", G_STRFUNC);
         return FALSE;
+    }
 
-    exists = g_file_test (module_path, G_FILE_TEST_EXISTS);
-    g_free (module_path);
-    return exists;
+    return get_application_plugin_type (ap_client_get_application_plugin_dir (),
+                                        application_name) != G_TYPE_INVALID;
 }
 
 /**
@@ -179,12 +904,7 @@ ap_client_load_application_plugin (AgApplication *application,
                                    AgAccount *account)
 {
     const gchar *application_name;
-    const gchar *plugin_dir;
-    gchar *module_path;
-    GModule *module;
     ApApplicationPlugin *plugin = NULL;
-    gboolean ok;
-    GType (*ap_module_get_object_type) (void);
     GType object_type;
 
     g_return_val_if_fail (AG_IS_ACCOUNT (account), NULL);
@@ -196,57 +916,117 @@ ap_client_load_application_plugin (AgApplication *application,
         return NULL;
     }
 
-    plugin_dir = g_getenv ("AP_APPLICATION_PLUGIN_DIR");
-    if (plugin_dir == NULL)
-        plugin_dir = LIBACCOUNT_PLUGIN_DIR "/applications";
-
-    module_path = g_module_build_path (plugin_dir, application_name);
-    module = g_module_open (module_path, 0);
-    if (module == NULL)
+    object_type = get_application_plugin_type (ap_client_get_application_plugin_dir (),
+                                               application_name);
+    if (object_type != G_TYPE_INVALID)
     {
-        /* The absence of an application plugin is not an exceptional
-         * condition; therefore, do not emit any warning here, but just return
-         * quietly. */
-        goto finish;
+        plugin = g_object_new (object_type,
+                               "application", application,
+                               "account", account,
+                               NULL);
     }
 
-    ok = g_module_symbol (module, "ap_module_get_object_type",
-                          (gpointer *)&ap_module_get_object_type);
-    if (G_UNLIKELY (!ok || ap_module_get_object_type == NULL))
-    {
-        g_critical ("%s: module %s does not export ap_module_get_object_type",
-                    G_STRFUNC, module_path);
-        g_module_close (module);
-        goto error;
-    }
+    return plugin;
+}
 
-    object_type = ap_module_get_object_type ();
-    if (G_UNLIKELY (!G_TYPE_IS_OBJECT (object_type)))
+/**
+ * ap_client_load_application_plugin_async:
+ * @application: the #AgApplication.
+ * @account: the #AgAccount to be edited.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @callback: a callback which will be invoked when the plugin has been
+ * loaded.
+ * @user_data: user data to be passed to the callback.
+ *
+ * Asynchronous version of ap_client_load_application_plugin(); see
+ * ap_client_load_plugin_async() for the details. When the operation is
+ * finished, @callback will be invoked; you can then call
+ * ap_client_load_application_plugin_finish() to get the plugin.
+ */
+void
+ap_client_load_application_plugin_async (AgApplication *application,
+                                         AgAccount *account,
+                                         GCancellable *cancellable,
+                                         GAsyncReadyCallback callback,
+                                         gpointer user_data)
+{
+    const gchar *application_name;
+    LoadPluginData *data;
+    GTask *task;
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, ap_client_load_application_plugin_async);
+
+    if (G_UNLIKELY (!AG_IS_ACCOUNT (account)))
     {
-        g_critical ("%s: module %s does not create a valid GObject",
-                    G_STRFUNC, module_path);
-        g_module_close (module);
-        goto error;
+        return_invalid_argument (task, "ap_client_load_application_plugin_async: "
+                                 "invalid account");
+        return;
     }
 
-    plugin = g_object_new (object_type,
-                           "application", application,
-                           "account", account,
-                           NULL);
-    if (G_UNLIKELY (!AP_IS_APPLICATION_PLUGIN (plugin)))
+    application_name = ag_application_get_name (application);
+    if (G_UNLIKELY (application_name == NULL))
     {
-        g_critical ("%s: module %s did not create a valid ApApplicationPlugin",
-                    G_STRFUNC, module_path);
-        g_module_close (module);
-        goto error;
+        g_warning ("%s: application has no name!", G_STRFUNC);
+        return_no_plugin (task);
+        return;
     }
 
-    /* Make sure that the module is not unloaded: the GType system doesn't
-     * support that. */
-    g_module_make_resident (module);
+    data = g_slice_new0 (LoadPluginData);
+    data->plugin_dir = g_strdup (ap_client_get_application_plugin_dir ());
+    data->plugin_name = g_strdup (application_name);
+    data->account = g_object_ref (account);
+    data->application = ag_application_ref (application);
 
-error:
-finish:
-    g_free (module_path);
-    return plugin;
+    load_plugin_in_thread (task, data);
+}
+
+/**
+ * ap_client_load_application_plugin_finish:
+ * @result: the #GAsyncResult obtained from the #GAsyncReadyCallback passed to
+ * ap_client_load_application_plugin_async().
+ * @error: location for error, or %NULL.
+ *
+ * Finishes the operation started with
+ * ap_client_load_application_plugin_async().
+ *
+ * Returns: (transfer full): a new #ApApplicationPlugin if a valid plugin was
+ * found, %NULL otherwise or if an error occurred.
+ */
+ApApplicationPlugin *
+ap_client_load_application_plugin_finish (GAsyncResult *result,
+                                          GError **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+    g_return_val_if_fail (g_async_result_is_tagged
+                          (result, ap_client_load_application_plugin_async),
+                          NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * ap_client_get_missing_application_plugin_stats:
+ * @n_hits: (out) (allow-none): location for the number of cache hits, or
+ * %NULL.
+ * @n_misses: (out) (allow-none): location for the number of cache misses,
+ * or %NULL.
+ *
+ * Get the statistics of the cache of missing application plugins. The
+ * applications which have no plugin are remembered, so that
+ * ap_client_load_application_plugin() doesn't look them up again until the
+ * application plugin directory changes.
+ * @n_hits is set to the number of lookups answered from the cache, @n_misses
+ * to the number of lookups which had to inspect the plugin directory.
+ */
+void
+ap_client_get_missing_application_plugin_stats (guint *n_hits,
+                                                guint *n_misses)
+{
+    G_LOCK (plugin_registry);
+    if (n_hits != NULL)
+        *n_hits = missing_application_plugins_hits;
+    if (n_misses != NULL)
+        *n_misses = missing_application_plugins_misses;
+    G_UNLOCK (plugin_registry);
 }
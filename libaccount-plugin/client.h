@@ -23,7 +23,8 @@
 #ifndef _AP_CLIENT_H_
 #define _AP_CLIENT_H_
 
-#include <glib.h>
+#include <gio/gio.h>
+#include <glib-object.h>
 #include <libaccounts-glib/ag-account.h>
 #include <libaccounts-glib/ag-application.h>
 
@@ -33,11 +34,37 @@ typedef struct _ApPlugin ApPlugin;
 typedef struct _ApApplicationPlugin ApApplicationPlugin;
 
 ApPlugin *ap_client_load_plugin (AgAccount *account);
+void ap_client_load_plugin_async (AgAccount *account,
+                                  GCancellable *cancellable,
+                                  GAsyncReadyCallback callback,
+                                  gpointer user_data);
+ApPlugin *ap_client_load_plugin_finish (GAsyncResult *result,
+                                        GError **error);
 gboolean ap_client_has_plugin (AgProvider *provider);
 
+gboolean ap_client_lookup_plugin_type (const gchar *plugin_name,
+                                       GType *object_type);
+void ap_client_invalidate_plugin_types (const gchar *plugin_name);
+
+gboolean ap_client_has_application_plugin (AgApplication *application);
 ApApplicationPlugin *
 ap_client_load_application_plugin (AgApplication *application,
                                    AgAccount *account);
+void
+ap_client_load_application_plugin_async (AgApplication *application,
+                                         AgAccount *account,
+                                         GCancellable *cancellable,
+                                         GAsyncReadyCallback callback,
+                                         gpointer user_data);
+ApApplicationPlugin *
+ap_client_load_application_plugin_finish (GAsyncResult *result,
+                                          GError **error);
+
+void ap_client_get_missing_application_plugin_stats (guint *n_hits,
+                                                     guint *n_misses);
+
+const gchar *ap_client_get_provider_plugin_dir (void);
+const gchar *ap_client_get_application_plugin_dir (void);
 
 G_END_DECLS
 
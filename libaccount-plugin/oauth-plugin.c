@@ -950,6 +950,23 @@ ap_oauth_plugin_build_widget (ApPlugin *plugin)
     }
 }
 
+static gboolean
+ap_oauth_plugin_has_widget (ApPlugin *plugin)
+{
+    AgAccount *account;
+
+    /* A subclass providing its own widget must be asked the expensive way */
+    if (AP_PLUGIN_GET_CLASS (plugin)->build_widget !=
+        ap_oauth_plugin_build_widget)
+    {
+        return AP_PLUGIN_CLASS (ap_oauth_plugin_parent_class)->has_widget
+            (plugin);
+    }
+
+    account = ap_plugin_get_account (plugin);
+    return account->id == 0 || ap_plugin_get_need_authentication (plugin);
+}
+
 static void
 ap_oauth_plugin_act_headless (ApPlugin *plugin)
 {
@@ -983,6 +1000,7 @@ ap_oauth_plugin_class_init (ApOAuthPluginClass *klass)
 
     plugin_class->build_widget = ap_oauth_plugin_build_widget;
     plugin_class->act_headless = ap_oauth_plugin_act_headless;
+    plugin_class->has_widget = ap_oauth_plugin_has_widget;
 
     klass->query_username = _ap_oauth_plugin_query_username;
     /**
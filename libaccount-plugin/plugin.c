@@ -296,6 +296,23 @@ _ap_plugin_delete_account (ApPlugin *self,
         delete_account_from_db (self, result);
 }
 
+static gboolean
+_ap_plugin_has_widget (ApPlugin *self)
+{
+    GtkWidget *widget;
+
+    /* Plugins which don't implement has_widget() give us no other way to
+     * know than building the widget. */
+    widget = ap_plugin_build_widget (self);
+    if (widget == NULL)
+        return FALSE;
+
+    g_object_ref_sink (widget);
+    gtk_widget_destroy (widget);
+    g_object_unref (widget);
+    return TRUE;
+}
+
 static void
 ap_plugin_class_init (ApPluginClass *klass)
 {
@@ -310,6 +327,7 @@ ap_plugin_class_init (ApPluginClass *klass)
     object_class->finalize = ap_plugin_finalize;
 
     klass->delete_account = _ap_plugin_delete_account;
+    klass->has_widget = _ap_plugin_has_widget;
 
     /**
      * ApPlugin:account:
@@ -655,6 +673,26 @@ ap_plugin_build_widget (ApPlugin *self)
     return AP_PLUGIN_GET_CLASS (self)->build_widget (self);
 }
 
+/**
+ * ap_plugin_has_widget:
+ * @self: the #ApPlugin.
+ *
+ * Check whether ap_plugin_build_widget() would return a widget, without
+ * building it. This is useful to decide whether some UI for editing the
+ * account should be offered to the user.
+ * This is a virtual method; the base implementation builds the widget and
+ * destroys it, so subclasses should override it whenever they can tell the
+ * answer in a cheaper way.
+ *
+ * Returns: %TRUE if the plugin provides a UI widget, %FALSE otherwise.
+ */
+gboolean
+ap_plugin_has_widget (ApPlugin *self)
+{
+    g_return_val_if_fail (AP_IS_PLUGIN (self), FALSE);
+    return AP_PLUGIN_GET_CLASS (self)->has_widget (self);
+}
+
 /**
  * ap_plugin_act_headless:
  * @self: the #ApPlugin.
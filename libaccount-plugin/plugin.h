@@ -54,7 +54,7 @@ struct _ApPluginClass
                             GAsyncReadyCallback callback,
                             gpointer user_data);
     void (*act_headless) (ApPlugin *self);
-    void (*_ap_reserved4) (void);
+    gboolean (*has_widget) (ApPlugin *self);
     void (*_ap_reserved5) (void);
     void (*_ap_reserved6) (void);
     void (*_ap_reserved7) (void);
@@ -103,6 +103,7 @@ void ap_plugin_set_error (ApPlugin *self, const GError *error);
 const GError *ap_plugin_get_error (ApPlugin *self);
 
 GtkWidget *ap_plugin_build_widget (ApPlugin *self);
+gboolean ap_plugin_has_widget (ApPlugin *self);
 
 void ap_plugin_act_headless (ApPlugin *self);
 
@@ -25,8 +25,12 @@ namespace Cc.Credentials
      * @param name the name, as supplied to Ag.Manager.get_provider ()
      * @param icon the icon of the application
      * @param description the description of the application
-     * @param plugin the plugin to configure account options, if any
-     * @param plugin_widget the widget to show when configuring account options
+     * @param has_plugin whether the application has a plugin to configure
+     * account options
+     * @param plugin the plugin to configure account options, which is only
+     * loaded when the options are requested, so that it is never reused
+     * @param plugin_widget the widget to show when configuring account options,
+     * which is only built when the options are requested
      * @param service_name the service name, as supplied to
      * Ag.Manager.get_service ()
      */
@@ -35,6 +39,7 @@ namespace Cc.Credentials
         public string name;
         public Icon icon;
         public string description;
+        public bool has_plugin;
         public Ap.ApplicationPlugin plugin;
         public Gtk.Widget plugin_widget;
         public string service_name;
@@ -45,12 +50,126 @@ namespace Cc.Credentials
  * Web credentials account applications model. Used to store details about
  * applications that can be integrated with an account, to be used in creating
  * widgets in a grid for describing the applications.
+ *
+ * The rows of the most recently shown accounts are kept in a least-recently
+ * used cache, so that switching back and forth between accounts does not
+ * list the applications and look up their plugins again. Only whether an
+ * application has a plugin is cached: the plugins are used interactively, so
+ * a new one is loaded each time that the options are shown. A cached entry is
+ * dropped when its account is updated or deleted, and the whole cache is
+ * dropped when the installed applications change.
+ *
+ * In progressive mode, the desktop files, icons and translated descriptions
+ * of the applications are resolved in a pool of worker threads. The rows are
+ * added in a stable order, by application name, as soon as the rows before
+ * them are resolved, and row_added is emitted for each of them.
  */
 public class Cc.Credentials.AccountApplicationsModel : Object
 {
-    private Ag.Manager manager;
+    private DataCatalog data_catalog;
     private Ag.Account current_account;
-    public List<AccountApplicationRow?> application_rows;
+    private CachedRows current_entry;
+    private HashTable<uint, CachedRows> cached_rows;
+    /* Account IDs of the cached rows, most recently used first. */
+    private Queue<uint> cache_order;
+    private uint max_cached_accounts = DEFAULT_CACHE_SIZE;
+    private bool progressive;
+    /* Incremented on each account change, to drop late results. */
+    private uint generation = 0;
+    /* Resolved jobs which wait for the jobs before them, keyed by index. */
+    private HashTable<int, ResolveJob> resolved_jobs;
+    private ResolveJob[] jobs = {};
+    private int next_job_index = 0;
+    private static ThreadPool<ResolveJob> resolve_pool;
+
+    /* Enough to hide the latency of reading the desktop files. */
+    private const int MAX_RESOLVE_THREADS = 4;
+
+    /**
+     * The default number of accounts whose rows are cached.
+     */
+    public const uint DEFAULT_CACHE_SIZE = 8;
+
+    /**
+     * The rows of one account.
+     */
+    private class CachedRows
+    {
+        public uint account_id;
+        public List<AccountApplicationRow?> rows;
+    }
+
+    /**
+     * The details of an application which do not involve widgets, and can be
+     * resolved in a worker thread.
+     */
+    private class ResolveJob
+    {
+        public AccountApplicationsModel model;
+        public DataCatalog data_catalog;
+        public uint generation;
+        public int index;
+        public string service_name;
+        public Ag.Application application;
+        public Ag.Service service;
+        public bool resolved;
+        public Icon icon;
+        public string description;
+        public bool has_plugin;
+    }
+
+    /**
+     * The rows for the current account. The list is owned by the model.
+     */
+    public List<AccountApplicationRow?> application_rows
+    {
+        get
+        {
+            return current_entry.rows;
+        }
+    }
+
+    /**
+     * The number of times that the rows of an account were computed, rather
+     * than taken from the cache.
+     */
+    public uint rows_computed { get; private set; default = 0; }
+
+    /**
+     * Whether all the rows for the current account have been added. This is
+     * false only while a progressive population is in progress.
+     */
+    public bool populated { get; private set; default = true; }
+
+    /**
+     * Emitted when a row is appended to application_rows during a
+     * progressive population.
+     *
+     * @param position the position of the new row
+     */
+    public signal void row_added (int position);
+
+    /**
+     * Emitted when the progressive population of the model has completed.
+     */
+    public signal void population_finished ();
+
+    /**
+     * The maximum number of accounts whose rows are cached, including the
+     * current account.
+     */
+    public uint cache_size
+    {
+        get
+        {
+            return max_cached_accounts;
+        }
+        set
+        {
+            max_cached_accounts = uint.max (value, 1);
+            trim_cache ();
+        }
+    }
 
     /**
      * Update the model when the current account changes.
@@ -73,8 +192,26 @@ public class Cc.Credentials.AccountApplicationsModel : Object
 
             current_account = value;
 
-            // Empty the model and repopulate it.
-            application_rows = new List <AccountApplicationRow?>();
+            // Drop the results of an unfinished population.
+            generation++;
+            resolved_jobs.remove_all ();
+            jobs = {};
+            populated = true;
+
+            var entry = cached_rows.lookup (value.id);
+            if (entry != null)
+            {
+                // Mark the entry as the most recently used.
+                cache_order.remove (value.id);
+                cache_order.push_head (value.id);
+                current_entry = entry;
+                return;
+            }
+
+            // Compute the rows, and cache them once they are complete.
+            current_entry = new CachedRows ();
+            current_entry.account_id = value.id;
+            rows_computed++;
             populate_model ();
         }
     }
@@ -83,16 +220,68 @@ public class Cc.Credentials.AccountApplicationsModel : Object
      * Create a new model for storing applications that can be used with an
      * account.
      *
-     * @param widget a Gtk.Widget to be used for looking up themed icons
+     * @param progressive if true, the rows are resolved in worker threads
+     * after the account is set, and row_added and population_finished are
+     * emitted as they are added
+     * @param data_catalog the catalog to list the applications from, or null
+     * for the default catalog
      */
-    public AccountApplicationsModel ()
+    public AccountApplicationsModel (bool progressive = false,
+                                     DataCatalog? data_catalog = null)
     {
-        manager = new Ag.Manager ();
+        this.progressive = progressive;
+        this.data_catalog = data_catalog ?? DataCatalog.get_default ();
+        current_entry = new CachedRows ();
+        cached_rows = new HashTable<uint, CachedRows> (direct_hash,
+                                                       direct_equal);
+        cache_order = new Queue<uint> ();
+        resolved_jobs = new HashTable<int, ResolveJob> (direct_hash,
+                                                        direct_equal);
+
+        this.data_catalog.changed.connect (clear_cache);
+        this.data_catalog.manager.account_updated.connect (on_account_changed);
+        this.data_catalog.manager.account_deleted.connect (on_account_changed);
+    }
+
+    /**
+     * Drop the cached rows of the least recently used accounts, until the
+     * cache is no bigger than cache_size.
+     */
+    private void trim_cache ()
+    {
+        while (cache_order.get_length () > max_cached_accounts)
+        {
+            cached_rows.remove (cache_order.pop_tail ());
+        }
+    }
+
+    /**
+     * Drop the cached rows of all accounts. The rows of the current account
+     * stay valid until the account changes.
+     */
+    private void clear_cache ()
+    {
+        cached_rows.remove_all ();
+        cache_order.clear ();
+    }
+
+    /**
+     * Drop the cached rows of an account which was updated or deleted.
+     *
+     * @param id the ID of the account
+     */
+    private void on_account_changed (uint id)
+    {
+        if (cached_rows.remove (id))
+        {
+            cache_order.remove (id);
+        }
     }
 
     /**
      * Populate the model with a list of applications that can use the services
-     * of the current account.
+     * of the current account. In progressive mode, the applications are
+     * resolved in worker threads, and the rows are added later.
      */
     private void populate_model ()
     {
@@ -101,29 +290,145 @@ public class Cc.Credentials.AccountApplicationsModel : Object
                                                                           null);
         foreach (var service in services)
         {
-            var applications = manager.list_applications_by_service (service);
+            var applications = data_catalog.list_applications_by_service (service);
             foreach (var application in applications)
             {
                 service_application.insert (service.get_name (), application);
             }
         }
 
-        service_application.foreach (add_application);
+        var sorted_jobs = new List<ResolveJob> ();
+        service_application.foreach ((service_name, application) =>
+        {
+            var job = new ResolveJob ();
+            job.model = this;
+            job.data_catalog = data_catalog;
+            job.generation = generation;
+            job.service_name = service_name;
+            job.application = application;
+            job.service = data_catalog.get_service (service_name);
+            sorted_jobs.prepend (job);
+        });
+
+        // Keep the order of the rows stable.
+        sorted_jobs.sort (compare_jobs);
+        foreach (var job in sorted_jobs)
+        {
+            job.index = jobs.length;
+            jobs += job;
+        }
+        next_job_index = 0;
 
-        // Reverse the list, as it was prepended to for efficiency.
-        application_rows.reverse ();
+        if (!progressive || !start_resolve_pool ())
+        {
+            foreach (var job in jobs)
+            {
+                resolve_job (job);
+                add_application (job);
+            }
+            jobs = {};
+            cache_current_entry ();
+            return;
+        }
+
+        populated = false;
+        if (jobs.length == 0)
+        {
+            finish_population ();
+            return;
+        }
+
+        foreach (var job in jobs)
+        {
+            try
+            {
+                resolve_pool.add (job);
+            }
+            catch (ThreadError error)
+            {
+                // Resolve the job in the main thread instead.
+                resolve_job (job);
+                on_job_resolved (job);
+            }
+        }
     }
 
     /**
-     * Add a single application to the model.
+     * Compare jobs by application name, and then by service name.
      *
-     * @param service_name the name of the Ag.Service
-     * @param application the Ag.Application to add to the model
+     * @param a the first job
+     * @param b the second job
+     * @return a negative value if a sorts before b, 0 if they are equal, or a
+     * positive value if a sorts after b
      */
-    private void add_application (string service_name,
-                                  Ag.Application? application)
+    private static int compare_jobs (ResolveJob a, ResolveJob b)
     {
-        var desktop_info = application.get_desktop_app_info ();
+        var result = strcmp (a.application.get_name (),
+                             b.application.get_name ());
+        if (result == 0)
+        {
+            result = strcmp (a.service_name, b.service_name);
+        }
+
+        return result;
+    }
+
+    /**
+     * Create the pool of worker threads shared by all models, if needed.
+     *
+     * @return true if the pool is available, false otherwise
+     */
+    private static bool start_resolve_pool ()
+    {
+        if (resolve_pool == null)
+        {
+            try
+            {
+                resolve_pool = new ThreadPool<ResolveJob>.with_owned_data (on_resolve_pool_job,
+                                                                           MAX_RESOLVE_THREADS,
+                                                                           false);
+            }
+            catch (ThreadError error)
+            {
+                warning ("Error creating worker threads: %s", error.message);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Resolve a job in a worker thread, and hand it back to its model in the
+     * main thread.
+     *
+     * @param job the job to resolve
+     */
+    private static void on_resolve_pool_job (owned ResolveJob job)
+    {
+        resolve_job (job);
+
+        Idle.add (() =>
+        {
+            /* Release the model in the main thread, even if the job is
+             * released last by the worker thread. */
+            var model = (owned) job.model;
+            model.on_job_resolved (job);
+            return false;
+        });
+    }
+
+    /**
+     * Resolve the desktop file, icon and description of an application, and
+     * whether it has a plugin, without creating the plugin. This does not use
+     * widgets, so it may be called from a worker thread.
+     *
+     * @param job the job to resolve
+     */
+    private static void resolve_job (ResolveJob job)
+    {
+        var application = job.application;
+        var desktop_info = job.data_catalog.get_desktop_app_info (application);
         if (desktop_info == null)
         {
             message ("No desktop app info found for application name: %s",
@@ -132,46 +437,113 @@ public class Cc.Credentials.AccountApplicationsModel : Object
         }
 
         // Load a themed application icon.
-        var app_icon = desktop_info.get_icon ();
-
-        var service = manager.get_service (service_name);
+        job.icon = desktop_info.get_icon ();
 
         var app_description = dgettext (application.get_i18n_domain (),
                                         application.get_description ());
         var app_service_usage = dgettext (application.get_i18n_domain (),
-                                          application.get_service_usage (service));
-        var description_markup = app_description
-                                 + "\n<small>"
-                                 + app_service_usage
-                                 + "</small>";
-
-        var app_plugin = Ap.client_load_application_plugin (application,
-                                                            current_account);
-        Gtk.Widget app_plugin_widget = null;
-        if (app_plugin == null)
-        {
-            /* There might not be a plugin (for OAuth accounts, or if there are
-             * no settings).
-             */
+                                          application.get_service_usage (job.service));
+        job.description = app_description
+                          + "\n<small>"
+                          + app_service_usage
+                          + "</small>";
+        /* There might not be a plugin (for OAuth accounts, or if there are
+         * no settings). */
+        job.has_plugin = Ap.client_has_application_plugin (application);
+        job.resolved = true;
+    }
+
+    /**
+     * Add the rows of the resolved jobs in order, once all the jobs before
+     * them are resolved.
+     *
+     * @param job a job which was resolved in a worker thread
+     */
+    private void on_job_resolved (ResolveJob job)
+    {
+        // The account changed since the job was started.
+        if (job.generation != generation)
+        {
+            return;
+        }
+
+        resolved_jobs.insert (job.index, job);
+
+        ResolveJob next_job;
+        while ((next_job = resolved_jobs.lookup (next_job_index)) != null)
+        {
+            resolved_jobs.remove (next_job_index);
+            next_job_index++;
+
+            if (add_application (next_job))
+            {
+                row_added ((int) current_entry.rows.length () - 1);
+            }
+        }
+
+        if (next_job_index == jobs.length)
+        {
+            jobs = {};
+            finish_population ();
+        }
+    }
+
+    /**
+     * Cache the rows of the current account, and tell that they are
+     * complete.
+     */
+    private void finish_population ()
+    {
+        cache_current_entry ();
+        populated = true;
+        population_finished ();
+    }
+
+    /**
+     * Put the complete rows of the current account in the cache.
+     */
+    private void cache_current_entry ()
+    {
+        cached_rows.insert (current_entry.account_id, current_entry);
+        cache_order.push_head (current_entry.account_id);
+        trim_cache ();
+    }
+
+    /**
+     * Add the row of a resolved application to the model.
+     *
+     * @param job the resolved application
+     * @return true if a row was added, false if the application could not be
+     * resolved
+     */
+    private bool add_application (ResolveJob job)
+    {
+        if (!job.resolved)
+        {
+            return false;
+        }
+
+        var application = job.application;
+        if (!job.has_plugin)
+        {
             message ("No valid plugin found for application '%s' with account '%u'",
                      application.get_name (),
                      current_account.id);
         }
-        else
-        {
-            app_plugin_widget = app_plugin.build_widget ();
-        }
 
         var application_row = AccountApplicationRow ()
         {
             name = application.get_name (),
-            icon = app_icon,
-            description = description_markup,
-            plugin = app_plugin,
-            plugin_widget = app_plugin_widget,
-            service_name = service_name
+            icon = job.icon,
+            description = job.description,
+            has_plugin = job.has_plugin,
+            plugin = null,
+            plugin_widget = null,
+            service_name = job.service_name
         };
 
-        application_rows.prepend (application_row);
+        current_entry.rows.append (application_row);
+
+        return true;
     }
 }
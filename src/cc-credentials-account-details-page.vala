@@ -24,46 +24,80 @@ private class Cc.Credentials.AccountApplicationButton : Gtk.Button
 {
     /**
      * An AccountApplicationRow, for showing the configuration widget from
-     * on_options_button_clicked().
+     * on_options_button_clicked(). It is replaced when the button is reused
+     * for another application.
      * 
      * This property is necessary because Vala generates incorrect C code if
      * using g_object_set_data() and g_object_get_data() with a boxed type.
      */
-    public AccountApplicationRow application_row { get; construct; }
+    public AccountApplicationRow application_row { get; set; }
 
-    public AccountApplicationButton (string label, AccountApplicationRow row)
+    public AccountApplicationButton (string label)
     {
-        Object (label: label, application_row: row);
+        Object (label: label);
     }
 }
 
 /**
- * Switch widget, additionally storing an AccountApplicationRow.
+ * Switch widget for enabling a service of an account. The switch can be
+ * bound to another account and service, so that it can be reused.
  */
 private class Cc.Credentials.AccountApplicationSwitch : Gtk.Switch
 {
-    public Ag.Account account { get; construct; }
-    public Ag.Service service { get; construct; }
+    public Ag.Account account { get; private set; }
+    public Ag.Service service { get; private set; }
     bool store_in_progress;
+    bool binding = false;
+    ulong enabled_handler = 0;
 
-    public AccountApplicationSwitch (Ag.Account acc, Ag.Service serv)
+    public AccountApplicationSwitch ()
     {
-        Object (account: acc, service: serv);
+        Object ();
     }
 
     construct
     {
         store_in_progress = false;
 
-        // Fetch current state from service.
+        set_tooltip_text (_("Control whether this application integrates with Online Accounts"));
+        notify["active"].connect (on_app_switch_activated);
+    }
+
+    /**
+     * Show and control the enabled state of a service of an account.
+     *
+     * @param acc the account
+     * @param serv the service of the account
+     */
+    public void bind (Ag.Account acc, Ag.Service serv)
+    {
+        unbind ();
+
+        account = acc;
+        service = serv;
+
+        // Fetch current state from service, without storing it back.
+        binding = true;
         account.select_service (service);
         active = account.get_enabled ();
         account.select_service (null);
+        binding = false;
+        sensitive = true;
 
         account.set_data ("switch", this);
-        account.enabled.connect (on_app_account_enabled);
-        set_tooltip_text (_("Control whether this application integrates with Online Accounts"));
-        notify["active"].connect (on_app_switch_activated);
+        enabled_handler = account.enabled.connect (on_app_account_enabled);
+    }
+
+    /**
+     * Stop following the enabled state of the current account.
+     */
+    public void unbind ()
+    {
+        if (enabled_handler != 0)
+        {
+            SignalHandler.disconnect (account, enabled_handler);
+            enabled_handler = 0;
+        }
     }
 
     /**
@@ -91,6 +125,11 @@ private class Cc.Credentials.AccountApplicationSwitch : Gtk.Switch
      */
     private void on_app_switch_activated ()
     {
+        if (binding || account == null)
+        {
+            return;
+        }
+
         // Toggle the enabled state.
         account.select_service (service);
         account.set_enabled (active);
@@ -131,6 +170,7 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
 {
     private AccountsModel accounts_store;
     private Ap.Plugin plugin;
+    private Cancellable plugin_cancellable;
     private Gtk.Frame frame;
     private Gtk.Label frame_label;
     private Gtk.Notebook action_notebook;
@@ -139,6 +179,11 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
     private Gtk.Label applications_grid_description;
     private Gtk.ScrolledWindow applications_scroll;
     private Gtk.Grid applications_grid;
+    /* Pool of grid rows, of which the first applications_grid_rows are
+     * bound to the applications of the current account. */
+    private ApplicationRowWidgets[] row_widgets = {};
+    private int applications_grid_rows = 0;
+    private string current_provider_display_name;
     private Gtk.ButtonBox buttonbox;
     private Gtk.Button edit_options_button;
     private AccountApplicationsModel applications_model;
@@ -147,6 +192,23 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
     private bool needs_attention = false;
     private bool store_in_progress = false;
 
+    /**
+     * The widgets of a row of the applications grid. Rows are kept when the
+     * account changes, and bound to the applications of the new account.
+     */
+    private class ApplicationRowWidgets
+    {
+        public Gtk.Image image;
+        public Gtk.Label label;
+        public AccountApplicationButton button;
+        public AccountApplicationSwitch app_switch;
+    }
+
+    /**
+     * The number of widgets created for the rows of the applications grid.
+     */
+    internal uint row_widgets_created { get; private set; default = 0; }
+
     /**
      * Pages for the action widget notebook.
      *
@@ -225,40 +287,16 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
              * of the integrated applications.
              */
 
-            plugin = Ap.client_load_plugin (value);
-            if (plugin == null)
-            {
-                warning ("No valid plugin found for provider %s",
-                         value.get_provider_name ());
-            }
-            else
+            /* The plugin is loaded in the background; until it is ready, the
+             * edit options button is not shown. */
+            plugin = null;
+            set_edit_options_button_present (false);
+            if (plugin_cancellable != null)
             {
-                var widget = plugin.build_widget ();
-                if (widget == null)
-                {
-                    debug ("No configuration widget for provider %s",
-                             value.get_provider_name ());
-                    if (edit_options_button_present)
-                    {
-                        buttonbox.remove (edit_options_button);
-                        edit_options_button_present = false;
-                    }
-                }
-                else
-                {
-                    if (!edit_options_button_present)
-                    {
-                        buttonbox.add (edit_options_button);
-                        buttonbox.set_child_secondary (edit_options_button,
-                                                       true);
-                        edit_options_button_present = true;
-                    }
-
-                    /* The configuration widget is instantiated by Preferences
-                     * when the edit options button is clicked. */
-                    widget.destroy ();
-                }
+                plugin_cancellable.cancel ();
             }
+            plugin_cancellable = new Cancellable ();
+            load_plugin.begin (value, plugin_cancellable);
 
 
             enabled_switch.active = value.get_enabled ();
@@ -266,27 +304,15 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
 
             var manager = accounts_store.manager;
             var provider = manager.get_provider (value.get_provider_name ());
-            var provider_display_name = provider.get_display_name ();
+            current_provider_display_name = provider.get_display_name ();
 
             update_needs_attention_ui_state ();
 
-            // Update the applications model.
+            /* Update the applications model. The rows which are not cached
+             * are added to the grid as they are resolved. */
             applications_model.account = value;
 
-            // Special-case having no consumer applications installed.
-            unowned List<AccountApplicationRow?> applications = applications_model.application_rows;
-
-            if (applications == null)
-            {
-                applications_grid_description.label = _("There are currently no applications installed which integrate with your %s account.").printf
-                                                      (provider_display_name);
-            }
-            else
-            {
-                applications_grid_description.label = _("The following applications integrate with your %s account:").printf
-                                                      (provider_display_name);
-            }
-
+            update_applications_grid_description ();
             populate_applications_grid ();
         }
     }
@@ -418,14 +444,21 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
      */
     private Gtk.Widget create_applications_grid ()
     {
-        applications_model = new AccountApplicationsModel ();
+        applications_model = new AccountApplicationsModel (true);
+        applications_model.row_added.connect (on_applications_model_row_added);
+        applications_model.population_finished.connect (update_applications_grid_description);
 
         applications_scroll = new Gtk.ScrolledWindow (null, null);
         var context = applications_scroll.get_style_context ();
         context.add_class ("ubuntu-online-accounts");
 
-        // Instantiates applications_grid.
-        populate_applications_grid ();
+        applications_grid = new Gtk.Grid ();
+        applications_grid.border_width = 6;
+        applications_grid.column_spacing = 12;
+        applications_grid.row_spacing = 12;
+        applications_grid.expand = true;
+        applications_scroll.add_with_viewport (applications_grid);
+        applications_scroll.show_all ();
 
         applications_scroll.window_placement_set = true;
 
@@ -471,79 +504,140 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
     }
 
     /**
-     * Populate the grid of applications from the model. Instantiates
-     * applications_grid.
+     * Populate the grid of applications from the model, reusing the rows of
+     * the grid.
      */
     private void populate_applications_grid ()
     {
-        if (applications_grid != null)
+        bind_applications_grid (applications_model.application_rows);
+    }
+
+    /**
+     * Bind the rows of the applications grid to a list of applications. Rows
+     * are only created if there are more applications than rows, and the
+     * surplus rows are hidden.
+     *
+     * @param applications the applications to show
+     */
+    internal void bind_applications_grid (List<AccountApplicationRow?> applications)
+    {
+        applications_grid_rows = 0;
+
+        foreach (var application in applications)
         {
-            applications_grid.destroy ();
+            add_application (application);
         }
 
-        applications_grid = new Gtk.Grid ();
-        applications_grid.border_width = 6;
-        applications_grid.column_spacing = 12;
-        applications_grid.row_spacing = 12;
-        applications_grid.expand = true;
+        for (var i = applications_grid_rows; i < row_widgets.length; i++)
+        {
+            var widgets = row_widgets[i];
+            widgets.image.hide ();
+            widgets.label.hide ();
+            widgets.button.hide ();
+            widgets.app_switch.unbind ();
+            widgets.app_switch.hide ();
+        }
+    }
 
+    /**
+     * Update the description above the applications grid, special-casing
+     * having no consumer applications installed.
+     */
+    private void update_applications_grid_description ()
+    {
         unowned List<AccountApplicationRow?> applications = applications_model.application_rows;
 
-        applications.foreach (add_application);
-
-        applications_scroll.add_with_viewport (applications_grid);
+        // Wait for the rows to be resolved before saying that there are none.
+        if (applications == null && applications_model.populated)
+        {
+            applications_grid_description.label = _("There are currently no applications installed which integrate with your %s account.").printf
+                                                  (current_provider_display_name);
+        }
+        else
+        {
+            applications_grid_description.label = _("The following applications integrate with your %s account:").printf
+                                                  (current_provider_display_name);
+        }
+    }
 
-        applications_scroll.show_all ();
+    /**
+     * Handle a row being resolved by the applications model, by appending it
+     * to the applications grid.
+     *
+     * @param position the position of the new row in the model
+     */
+    private void on_applications_model_row_added (int position)
+    {
+        var application = applications_model.application_rows.nth_data (position);
+        add_application (application);
     }
 
     /**
-     * Add an individual application from the model to the applications grid.
+     * Show an individual application from the model in the next row of the
+     * applications grid, creating the row if needed.
      *
      * @param application the description of the application
      */
     private void add_application (AccountApplicationRow? application)
     {
-        applications_grid.insert_row (0);
+        if (applications_grid_rows == row_widgets.length)
+        {
+            row_widgets += create_row_widgets (applications_grid_rows);
+        }
+
+        var widgets = row_widgets[applications_grid_rows++];
 
-        var image = new Gtk.Image.from_gicon (application.icon,
-                                              Gtk.IconSize.DND);
-        image.margin_left = 4;
-        applications_grid.attach (image, 0, 0, 1, 1);
+        widgets.image.set_from_gicon (application.icon, Gtk.IconSize.DND);
+        widgets.image.show ();
 
-        var label = new Gtk.Label (application.description);
-        label.hexpand = true;
-        label.use_markup = true;
-        label.xalign = 0.0f;
-        applications_grid.attach_next_to (label,
-                                          image,
-                                          Gtk.PositionType.RIGHT,
-                                          1,
-                                          1);
+        widgets.label.label = application.description;
+        widgets.label.show ();
+
+        widgets.button.application_row = application;
+        widgets.button.visible = application.has_plugin;
 
         var service = accounts_store.manager.get_service (application.service_name);
-        var app_switch = new AccountApplicationSwitch (account, service);
+        widgets.app_switch.bind (account, service);
+        widgets.app_switch.show ();
+    }
 
-        if (application.plugin_widget != null)
-        {
-            var button = new AccountApplicationButton (_("Options"),
-                                                       application);
-            applications_grid.attach_next_to (button,
-                                              label,
-                                              Gtk.PositionType.RIGHT,
-                                              1,
-                                              1);
-            applications_grid.attach_next_to (app_switch,
-                                              button,
-                                              Gtk.PositionType.RIGHT,
-                                              1,
-                                              1);
+    /**
+     * Create the widgets of a row of the applications grid. The widgets are
+     * shown when the row is bound to an application.
+     *
+     * @param top the index of the row in the grid
+     * @return the widgets of the row
+     */
+    private ApplicationRowWidgets create_row_widgets (int top)
+    {
+        var widgets = new ApplicationRowWidgets ();
 
-            button.clicked.connect (on_options_button_clicked);
-        }
-        else
-        {
-            applications_grid.attach (app_switch, 3, 0, 1, 1);
-        }
+        widgets.image = new Gtk.Image ();
+        widgets.image.margin_left = 4;
+        applications_grid.attach (widgets.image, 0, top, 1, 1);
+
+        widgets.label = new Gtk.Label (null);
+        widgets.label.hexpand = true;
+        widgets.label.use_markup = true;
+        widgets.label.xalign = 0.0f;
+        applications_grid.attach (widgets.label, 1, top, 1, 1);
+
+        widgets.button = new AccountApplicationButton (_("Options"));
+        applications_grid.attach (widgets.button, 2, top, 1, 1);
+        widgets.button.clicked.connect (on_options_button_clicked);
+
+        widgets.app_switch = new AccountApplicationSwitch ();
+        applications_grid.attach (widgets.app_switch, 3, top, 1, 1);
+
+        // Keep the unbound widgets and the missing buttons hidden.
+        widgets.image.no_show_all = true;
+        widgets.label.no_show_all = true;
+        widgets.button.no_show_all = true;
+        widgets.app_switch.no_show_all = true;
+
+        row_widgets_created += 4;
+
+        return widgets;
     }
 
     /**
@@ -574,6 +668,82 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
         }
     }
 
+    /**
+     * Get the shared account plugin for the selected account, and show the
+     * edit options button if the plugin provides a configuration widget.
+     *
+     * @param account the account selected when the load was started
+     * @param cancellable cancelled when a different account is selected
+     */
+    private async void load_plugin (Ag.Account account,
+                                    Cancellable cancellable)
+    {
+        Ap.Plugin loaded_plugin = null;
+
+        try
+        {
+            loaded_plugin = yield PluginCache.get_default ().load_shared_async (account,
+                                                                                cancellable);
+        }
+        catch (IOError.CANCELLED error)
+        {
+            return;
+        }
+        catch (Error error)
+        {
+            warning ("Error loading plugin for provider %s: %s",
+                     account.get_provider_name (), error.message);
+        }
+
+        if (cancellable.is_cancelled ())
+        {
+            return;
+        }
+
+        plugin = loaded_plugin;
+        if (plugin == null)
+        {
+            warning ("No valid plugin found for provider %s",
+                     account.get_provider_name ());
+        }
+        else if (!plugin.has_widget ())
+        {
+            debug ("No configuration widget for provider %s",
+                   account.get_provider_name ());
+        }
+        else
+        {
+            /* The configuration widget is instantiated by Preferences when
+             * the edit options button is clicked. */
+            set_edit_options_button_present (true);
+        }
+    }
+
+    /**
+     * Add or remove the edit options button from the button box.
+     *
+     * @param present whether the button should be shown
+     */
+    private void set_edit_options_button_present (bool present)
+    {
+        if (present == edit_options_button_present)
+        {
+            return;
+        }
+
+        if (present)
+        {
+            buttonbox.add (edit_options_button);
+            buttonbox.set_child_secondary (edit_options_button, true);
+        }
+        else
+        {
+            buttonbox.remove (edit_options_button);
+        }
+
+        edit_options_button_present = present;
+    }
+
     /**
      * Handle the remove account button being clicked. The removal is
      * asynchronous, and on_remove_account_finished() is called when the
@@ -608,30 +778,7 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
             case Gtk.ResponseType.ACCEPT:
                 // TODO: Set the UI to be insensitive during account removal?
 
-                var plugin = Ap.client_load_plugin (current_account);
-                if (plugin == null)
-                {
-                    /* This can really happen, if the plugin has been
-                     * uninstalled; in this case, the user can still access the
-                     * account (to disable or delete it).
-                     */
-                    warning ("No valid plugin found for provider %s",
-                             current_account.get_provider_name ());
-                    // TODO: Delete the account in this case.
-                    break;
-                }
-
-                plugin.delete_account.begin ((obj, res) => {
-                    try
-                    {
-                        plugin.delete_account.end (res);
-                    }
-                    catch (Error error)
-                    {
-                        critical ("Error deleting account: %s", error.message);
-                    }
-                    on_remove_account_finished (current_account);
-                });
+                remove_account.begin (current_account);
                 break;
             case Gtk.ResponseType.CANCEL:
             case Gtk.ResponseType.DELETE_EVENT:
@@ -643,6 +790,49 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
         confirmation.destroy ();
     }
 
+    /**
+     * Get the shared plugin for the account, and let it delete the account.
+     *
+     * @param account the account to remove
+     */
+    private async void remove_account (Ag.Account account)
+    {
+        Ap.Plugin removal_plugin = null;
+
+        try
+        {
+            removal_plugin = yield PluginCache.get_default ().load_shared_async (account);
+        }
+        catch (Error error)
+        {
+            warning ("Error loading plugin for provider %s: %s",
+                     account.get_provider_name (), error.message);
+        }
+
+        if (removal_plugin == null)
+        {
+            /* This can really happen, if the plugin has been
+             * uninstalled; in this case, the user can still access the
+             * account (to disable or delete it).
+             */
+            warning ("No valid plugin found for provider %s",
+                     account.get_provider_name ());
+            // TODO: Delete the account in this case.
+            return;
+        }
+
+        try
+        {
+            yield removal_plugin.delete_account ();
+        }
+        catch (Error error)
+        {
+            critical ("Error deleting account: %s", error.message);
+        }
+        PluginCache.get_default ().evict (account.id);
+        on_remove_account_finished (account);
+    }
+
     /**
      * Handle the completion of the asynchronous account removal operation.
      *
@@ -740,17 +930,62 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
      * Handle the options button for an application being clicked.
      *
      * @param button the AccountApplicationButton that emitted the clicked
-     * signal. The account application plugin is a property on the button.
+     * signal. The row of the application is a property on the button.
      */
     private void on_options_button_clicked (Gtk.Button button)
     {
         var app_button = button as AccountApplicationButton;
-        var application_row = app_button.application_row;
 
+        show_application_options.begin (app_button.application_row,
+                                        current_account);
+    }
+
+    /**
+     * Load a fresh plugin for editing the options of an application, as a
+     * plugin which already finished must not be reused, and build its
+     * configuration widget.
+     *
+     * @param application_row the row of the application
+     * @param account the account to edit
+     */
+    private async void show_application_options (AccountApplicationRow application_row,
+                                                 Ag.Account account)
+    {
+        var application = account.manager.get_application (application_row.name);
+        if (application == null)
+        {
+            warning ("Application '%s' not found", application_row.name);
+            return;
+        }
+
+        try
+        {
+            application_row.plugin = yield Ap.client_load_application_plugin_async (application,
+                                                                                    account);
+        }
+        catch (Error error)
+        {
+            warning ("Error loading plugin for application '%s': %s",
+                     application_row.name, error.message);
+        }
+
+        // Ignore the plugin if a different account was selected meanwhile.
+        if (application_row.plugin == null || account != current_account)
+        {
+            return;
+        }
+
+        // Build the configuration widget only when it is needed.
+        application_row.plugin_widget = application_row.plugin.build_widget ();
         if (application_row.plugin_widget != null)
         {
             account_options_request (application_row);
         }
+        else
+        {
+            warning ("Error building configuration widget for application '%s'",
+                     application_row.name);
+        }
     }
 
     /**
@@ -758,7 +993,39 @@ public class Cc.Credentials.AccountDetailsPage : Gtk.Grid
      */
     private void on_edit_options_button_clicked ()
     {
-        account_edit_options_request (plugin);
+        if (plugin == null)
+        {
+            return;
+        }
+
+        edit_account_options.begin (current_account);
+    }
+
+    /**
+     * Load a fresh plugin for editing the options of an account, as the
+     * shared plugin must not be used interactively.
+     *
+     * @param account the account to edit
+     */
+    private async void edit_account_options (Ag.Account account)
+    {
+        Ap.Plugin options_plugin = null;
+
+        try
+        {
+            options_plugin = yield PluginCache.get_default ().load_fresh_async (account);
+        }
+        catch (Error error)
+        {
+            warning ("Error loading plugin for provider %s: %s",
+                     account.get_provider_name (), error.message);
+        }
+
+        // Ignore the plugin if a different account was selected meanwhile.
+        if (options_plugin != null && account == current_account)
+        {
+            account_edit_options_request (options_plugin);
+        }
     }
 
     /**
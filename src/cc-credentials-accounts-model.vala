@@ -17,16 +17,61 @@
  *      David King <david.king@canonical.com>
  */
 
-// FIXME: Make the model sortable.
 /**
- * Web credentials accounts Gtk.ListStore. Used as a model for the accounts
+ * Web credentials accounts Gtk.TreeModel. Used as a model for the accounts
  * stored by libaccounts-glib.
+ *
+ * The rows are kept in a contiguous array of small structs, which reference
+ * the provider data shared by all the accounts of the same provider; the
+ * column values are only built when they are requested. A row keeps the same
+ * slot in the array for as long as it exists, and the display order is kept
+ * in a balanced sequence of slots, so that rows can be inserted and moved in
+ * logarithmic time. The ‘Add account…’ row is not stored, and always comes
+ * after the account rows.
  */
-public class Cc.Credentials.AccountsModel : Gtk.ListStore
+public class Cc.Credentials.AccountsModel : Object, Gtk.TreeModel
 {
+    private DataCatalog data_catalog;
     private Ag.Manager accounts_manager;
-    private uint[] past_failures;
-    private WebcredentialsIndicator indicator;
+    /* The failing accounts, sorted by account ID and without duplicates. */
+    private uint[] past_failures = {};
+    private WebcredentialsIndicatorClient indicator;
+    private AccountRow[] rows = {};
+    /* Slots of the rows array left free by removed rows. */
+    private int[] free_slots = {};
+    /* Index of the slots of the rows of the model, keyed by account ID. */
+    private HashTable<uint, int> account_rows;
+    /* The slots of the rows, in display order. */
+    private Sequence<int> order;
+    /* The slots of the rows, sorted by display name, for prefix lookups. */
+    private Sequence<int> names;
+    /* The name key that PROBE_SLOT stands for, during a prefix lookup. */
+    private string? search_key;
+    private SortOrder current_sort_order = SortOrder.ACCOUNT_ID;
+    private HashTable<string, ProviderData> providers;
+    /* Iters hold the slot of their row, which does not change while the row
+     * exists. */
+    private int stamp = 1;
+    private string add_account_text;
+    private Icon add_account_icon;
+    /* Accounts whose rows are still placeholders, in display order. */
+    private Queue<uint> pending_accounts;
+    private uint populate_source = 0;
+    /* Accounts updated since the last update_accounts() call. */
+    private HashTable<uint, bool> pending_updates;
+    private uint update_source = 0;
+    private HashTable<uint, AccountSubscription> account_subscriptions;
+
+    /**
+     * Maximum time spent resolving placeholder rows in one idle callback, in
+     * microseconds, so that the UI stays responsive while populating.
+     */
+    private const int64 POPULATE_BATCH_BUDGET = 8000;
+
+    /* The slot of the ‘Add account…’ row, which is not stored. */
+    private const int ADD_ACCOUNT_SLOT = -1;
+    /* The slot compared against the rows when searching the name index. */
+    private const int PROBE_SLOT = -2;
 
     /**
      * Identifiers for columns in the accounts model.
@@ -52,15 +97,85 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
         NEEDS_ATTENTION = 6
     }
 
-    private struct ColumnRecord
+    /**
+     * Orderings of the account rows. Rows which compare equal are ordered by
+     * account ID, and the ‘Add account…’ row always stays last.
+     *
+     * @param ACCOUNT_ID the order in which the accounts were created
+     * @param PROVIDER by provider display name, then by account display name
+     * @param DISPLAY_NAME by account display name
+     * @param ENABLED enabled accounts before disabled ones
+     * @param NEEDS_ATTENTION accounts which need attention first
+     */
+    public enum SortOrder
+    {
+        ACCOUNT_ID,
+        PROVIDER,
+        DISPLAY_NAME,
+        ENABLED,
+        NEEDS_ATTENTION
+    }
+
+    /**
+     * The signal handlers connected to the Ag.Account of a row. There is at
+     * most one subscription for each row, and it is dropped together with
+     * the row.
+     */
+    private class AccountSubscription
     {
-        public uint account_id;
         public Ag.Account account;
+        public ulong enabled_handler;
+        public ulong display_name_changed_handler;
+    }
+
+    /**
+     * Provider details, shared by the rows of all the accounts of the same
+     * provider.
+     */
+    internal class ProviderData
+    {
+        public string name;
+        public string display_name;
+        public string sort_key;
         public Icon icon;
-        public Gdk.Pixbuf translucent_pixbuf;
-        public string description;
+    }
+
+    /**
+     * A row of the model. The description markup is not stored, but built
+     * from the provider and the display name when it is requested. The name
+     * key and the positions in the sequences are maintained by the model.
+     */
+    internal struct AccountRow
+    {
+        public uint account_id;
+        public Ag.Account account;
+        public ProviderData provider;
+        public string display_name;
         public bool enabled;
         public bool attention;
+        public string name_key;
+        public unowned SequenceIter<int> position;
+        public unowned SequenceIter<int> name_position;
+    }
+
+    /**
+     * The order of the account rows. Changing it reorders the existing rows,
+     * and rows are kept in this order as they are added and updated.
+     */
+    public SortOrder sort_order
+    {
+        get
+        {
+            return current_sort_order;
+        }
+        set
+        {
+            if (value != current_sort_order)
+            {
+                current_sort_order = value;
+                resort_rows ();
+            }
+        }
     }
 
     /**
@@ -75,10 +190,42 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
     }
 
     /**
-     * The Webcredentials interface used to report account authentication
-     * failures.
+     * Whether all the rows of the model have been resolved. This is false
+     * only while a progressive population is in progress.
+     */
+    public bool populated { get; private set; default = true; }
+
+    /**
+     * Emitted when the progressive population of the model has completed.
+     */
+    public signal void population_finished ();
+
+    /**
+     * The number of account-updated notifications received.
+     */
+    public uint updates_received { get; private set; default = 0; }
+
+    /**
+     * The number of account updates which changed a row of the model.
+     */
+    public uint updates_applied { get; private set; default = 0; }
+
+    /**
+     * The number of accounts whose signals are currently connected.
+     */
+    public uint subscription_count
+    {
+        get
+        {
+            return account_subscriptions.size ();
+        }
+    }
+
+    /**
+     * The Webcredentials indicator client used to report account
+     * authentication failures.
      */
-    public WebcredentialsIndicator webcredentials_interface
+    public WebcredentialsIndicatorClient webcredentials_interface
     {
         get
         {
@@ -88,64 +235,555 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
 
     /**
      * Create a new data model for the list of accounts.
+     *
+     * @param progressive if true, only placeholder rows holding the account
+     * IDs are added at construction time, and they are filled in from idle
+     * callbacks; population_finished is emitted once all rows are complete
+     * @param data_catalog the catalog holding the account manager, or null for
+     * the default catalog
      */
-    public AccountsModel ()
+    public AccountsModel (bool progressive = false,
+                          DataCatalog? data_catalog = null)
     {
-        Type[] types = { typeof (uint), typeof (Ag.Account), typeof (Icon),
-                         typeof (Gdk.Pixbuf), typeof (string), typeof (bool),
-                         typeof (bool) };
-        set_column_types (types);
-
-        accounts_manager = new Ag.Manager ();
+        account_rows = new HashTable<uint, int> (direct_hash, direct_equal);
+        order = new Sequence<int> ();
+        names = new Sequence<int> ();
+        providers = new HashTable<string, ProviderData> (str_hash, str_equal);
+        pending_updates = new HashTable<uint, bool> (direct_hash, direct_equal);
+        account_subscriptions =
+            new HashTable<uint, AccountSubscription> (direct_hash,
+                                                      direct_equal);
+        this.data_catalog = data_catalog ?? DataCatalog.get_default ();
+        accounts_manager = this.data_catalog.manager;
         // Add a placeholder row at the end of the list.
-        var add_account_text = _("Add account…");
+        add_account_text = _("Add account…");
 
         // Load a themed icon for the action of adding accounts.
-        Icon provider_icon = null;
-
         try
         {
-            provider_icon = Icon.new_for_string ("credentials-add-account");
+            add_account_icon = Icon.new_for_string ("credentials-add-account");
         }
         catch (Error error)
         {
             message ("Error looking up themed add icon: %s", error.message);
         }
 
-        insert_with_values (null, 0,
-                            ModelColumns.ACCOUNT_ID, 0,
-                            ModelColumns.PROVIDER_ICON, provider_icon,
-                            ModelColumns.ACCOUNT_DESCRIPTION, add_account_text,
-                            ModelColumns.ENABLED, true,
-                            ModelColumns.NEEDS_ATTENTION, false,
-                            -1);
-
         var accounts = accounts_manager.list ();
 
         // Sort by account ID.
         accounts.sort ((a, b) => { return (int)a - (int)b; });
-        accounts.foreach (add_account);
-
-        try
+        if (progressive)
         {
-
-            indicator = Bus.get_proxy_sync (BusType.SESSION,
-                                            "com.canonical.indicators.webcredentials",
-                                            "/com/canonical/indicators/webcredentials");
-
-            var indicator_proxy = indicator as DBusProxy;
-            indicator_proxy.g_properties_changed.connect (on_proxy_properties_changed);
-            // Get the current list of failures.
-            on_indicator_notify_failures ();
+            pending_accounts = new Queue<uint> ();
+            accounts.foreach (add_placeholder_account);
+            if (!pending_accounts.is_empty ())
+            {
+                populated = false;
+                populate_source = Idle.add (populate_batch);
+            }
         }
-        catch (IOError err)
+        else
         {
-            warning ("Error initializing indicator proxy: %s\nAccount attention monitoring will be disabled", err.message);
+            accounts.foreach (add_account);
         }
 
+        /* The indicator client connects asynchronously, and notifies of
+         * the failures once it is ready. */
+        indicator = WebcredentialsIndicatorClient.get_default ();
+        indicator.failures_changed.connect (on_indicator_notify_failures);
+        // Get the current list of failures.
+        on_indicator_notify_failures ();
+
         accounts_manager.account_created.connect (on_account_created);
         accounts_manager.account_deleted.connect (on_account_deleted);
         accounts_manager.account_updated.connect (on_account_updated);
+        this.data_catalog.changed.connect (on_data_catalog_changed);
+    }
+
+    public Type get_column_type (int index)
+    {
+        switch (index)
+        {
+            case ModelColumns.ACCOUNT_ID:
+                return typeof (uint);
+            case ModelColumns.ACCOUNT:
+                return typeof (Ag.Account);
+            case ModelColumns.PROVIDER_ICON:
+                return typeof (Icon);
+            case ModelColumns.TRANSLUCENT_PIXBUF:
+                return typeof (Gdk.Pixbuf);
+            case ModelColumns.ACCOUNT_DESCRIPTION:
+                return typeof (string);
+            case ModelColumns.ENABLED:
+            case ModelColumns.NEEDS_ATTENTION:
+                return typeof (bool);
+            default:
+                return Type.INVALID;
+        }
+    }
+
+    public Gtk.TreeModelFlags get_flags ()
+    {
+        return Gtk.TreeModelFlags.ITERS_PERSIST | Gtk.TreeModelFlags.LIST_ONLY;
+    }
+
+    public int get_n_columns ()
+    {
+        return ModelColumns.NEEDS_ATTENTION + 1;
+    }
+
+    public bool get_iter (out Gtk.TreeIter iter, Gtk.TreePath path)
+    {
+        if (path.get_depth () != 1)
+        {
+            iter = Gtk.TreeIter ();
+            return false;
+        }
+
+        return iter_nth_child (out iter, null, path.get_indices ()[0]);
+    }
+
+    public Gtk.TreePath? get_path (Gtk.TreeIter iter)
+    {
+        int slot;
+        if (!lookup_iter_slot (iter, out slot))
+        {
+            return null;
+        }
+
+        return new Gtk.TreePath.from_indices (position_of_slot (slot));
+    }
+
+    public void get_value (Gtk.TreeIter iter, int column, out Value value)
+    {
+        int slot;
+
+        value = Value (get_column_type (column));
+        if (!lookup_iter_slot (iter, out slot))
+        {
+            return;
+        }
+
+        // The "Add account…" row.
+        if (slot == ADD_ACCOUNT_SLOT)
+        {
+            switch (column)
+            {
+                case ModelColumns.ACCOUNT_ID:
+                    value.set_uint (0);
+                    break;
+                case ModelColumns.PROVIDER_ICON:
+                    value.set_object (add_account_icon);
+                    break;
+                case ModelColumns.ACCOUNT_DESCRIPTION:
+                    value.set_string (add_account_text);
+                    break;
+                case ModelColumns.ENABLED:
+                    value.set_boolean (true);
+                    break;
+                default:
+                    break;
+            }
+            return;
+        }
+
+        // Access the row in place, rather than copying the struct.
+        switch (column)
+        {
+            case ModelColumns.ACCOUNT_ID:
+                value.set_uint (rows[slot].account_id);
+                break;
+            case ModelColumns.ACCOUNT:
+                value.set_object (rows[slot].account);
+                break;
+            case ModelColumns.PROVIDER_ICON:
+                var icon_provider = rows[slot].provider;
+                if (icon_provider != null)
+                {
+                    value.set_object (icon_provider.icon);
+                }
+                break;
+            case ModelColumns.TRANSLUCENT_PIXBUF:
+                var pixbuf_provider = rows[slot].provider;
+                if (pixbuf_provider != null)
+                {
+                    var icon_cache = TranslucentIconCache.get_default ();
+                    value.set_object (icon_cache.lookup (pixbuf_provider.icon,
+                                                         32, // Size in pixels.
+                                                         1)); // Scale factor.
+                }
+                break;
+            case ModelColumns.ACCOUNT_DESCRIPTION:
+                value.set_string (format_account_description (rows[slot].provider,
+                                                              rows[slot].display_name,
+                                                              rows[slot].enabled));
+                break;
+            case ModelColumns.ENABLED:
+                value.set_boolean (rows[slot].enabled);
+                break;
+            case ModelColumns.NEEDS_ATTENTION:
+                value.set_boolean (rows[slot].attention);
+                break;
+            default:
+                break;
+        }
+    }
+
+    public bool iter_children (out Gtk.TreeIter iter, Gtk.TreeIter? parent)
+    {
+        return iter_nth_child (out iter, parent, 0);
+    }
+
+    public bool iter_has_child (Gtk.TreeIter iter)
+    {
+        return false;
+    }
+
+    public int iter_n_children (Gtk.TreeIter? iter)
+    {
+        if (iter != null)
+        {
+            return 0;
+        }
+
+        // The account rows, and the "Add account…" row.
+        return order.get_length () + 1;
+    }
+
+    public bool iter_next (ref Gtk.TreeIter iter)
+    {
+        int slot;
+        if (!lookup_iter_slot (iter, out slot) || slot == ADD_ACCOUNT_SLOT)
+        {
+            iter.stamp = 0;
+            return false;
+        }
+
+        var next = rows[slot].position.next ();
+        slot = next.is_end () ? ADD_ACCOUNT_SLOT : next.get ();
+        iter.user_data = slot.to_pointer ();
+        return true;
+    }
+
+    public bool iter_nth_child (out Gtk.TreeIter iter,
+                                Gtk.TreeIter? parent,
+                                int n)
+    {
+        iter = Gtk.TreeIter ();
+
+        var n_rows = order.get_length ();
+        if (parent != null || n < 0 || n > n_rows)
+        {
+            return false;
+        }
+
+        var slot = n == n_rows ? ADD_ACCOUNT_SLOT
+                               : order.get_iter_at_pos (n).get ();
+        iter = iter_for_slot (slot);
+        return true;
+    }
+
+    public bool iter_parent (out Gtk.TreeIter iter, Gtk.TreeIter child)
+    {
+        iter = Gtk.TreeIter ();
+        return false;
+    }
+
+    /**
+     * Get an iter for the row stored in the given slot.
+     *
+     * @param slot the slot of the row, or ADD_ACCOUNT_SLOT
+     * @return a Gtk.TreeIter pointing to the row
+     */
+    private Gtk.TreeIter iter_for_slot (int slot)
+    {
+        var iter = Gtk.TreeIter ();
+        iter.stamp = stamp;
+        iter.user_data = slot.to_pointer ();
+        return iter;
+    }
+
+    /**
+     * Get the slot of the row that an iter points to.
+     *
+     * @param iter the Gtk.TreeIter to check
+     * @param slot the slot of the row, ADD_ACCOUNT_SLOT for the "Add account…"
+     * row
+     * @return true if the iter points to a row of the model, false otherwise
+     */
+    private bool lookup_iter_slot (Gtk.TreeIter iter, out int slot)
+    {
+        slot = int.from_pointer (iter.user_data);
+
+        if (iter.stamp != stamp || slot < ADD_ACCOUNT_SLOT
+            || slot >= rows.length)
+        {
+            return false;
+        }
+
+        return slot == ADD_ACCOUNT_SLOT || rows[slot].position != null;
+    }
+
+    /**
+     * Get the position of the row stored in the given slot.
+     *
+     * @param slot the slot of the row, or ADD_ACCOUNT_SLOT
+     * @return the position of the row in the model
+     */
+    private int position_of_slot (int slot)
+    {
+        if (slot == ADD_ACCOUNT_SLOT)
+        {
+            return order.get_length ();
+        }
+
+        return rows[slot].position.get_position ();
+    }
+
+    /**
+     * Emit row-changed for the row stored in the given slot.
+     *
+     * @param slot the slot of the changed row
+     */
+    private void emit_row_changed (int slot)
+    {
+        var path = new Gtk.TreePath.from_indices (position_of_slot (slot));
+        row_changed (path, iter_for_slot (slot));
+    }
+
+    /**
+     * Emit rows-reordered for a single row which moved.
+     *
+     * @param old_position the position of the row before it moved
+     * @param new_position the position of the row after it moved
+     */
+    private void emit_row_moved (int old_position, int new_position)
+    {
+        // The account rows, and the "Add account…" row, which never moves.
+        var new_order = new int[order.get_length () + 1];
+        for (var i = 0; i < new_order.length; i++)
+        {
+            new_order[i] = i;
+        }
+
+        if (old_position < new_position)
+        {
+            for (var i = old_position; i < new_position; i++)
+            {
+                new_order[i] = i + 1;
+            }
+        }
+        else
+        {
+            for (var i = new_position + 1; i <= old_position; i++)
+            {
+                new_order[i] = i - 1;
+            }
+        }
+        new_order[new_position] = old_position;
+
+        rows_reordered (new Gtk.TreePath (), null, new_order);
+    }
+
+    /**
+     * Sort all the rows again after the sort order changed.
+     */
+    private void resort_rows ()
+    {
+        var old_positions = new int[rows.length];
+        var position = 0;
+        for (var iter = order.get_begin_iter (); !iter.is_end (); iter = iter.next ())
+        {
+            old_positions[iter.get ()] = position++;
+        }
+
+        order.sort (compare_rows);
+
+        var new_order = new int[order.get_length () + 1];
+        position = 0;
+        for (var iter = order.get_begin_iter (); !iter.is_end (); iter = iter.next ())
+        {
+            new_order[position++] = old_positions[iter.get ()];
+        }
+        new_order[position] = position;
+
+        rows_reordered (new Gtk.TreePath (), null, new_order);
+    }
+
+    /**
+     * Move a row to its sorted position after its contents changed, and
+     * emit row-changed for it.
+     *
+     * @param slot the slot of the changed row
+     * @param name_changed whether the display name of the row changed
+     */
+    private void reposition_row (int slot, bool name_changed)
+    {
+        if (name_changed)
+        {
+            rows[slot].name_key = make_name_key (rows[slot].display_name);
+            Sequence.sort_changed (rows[slot].name_position, compare_names);
+        }
+
+        var old_position = rows[slot].position.get_position ();
+        Sequence.sort_changed (rows[slot].position, compare_rows);
+        var new_position = rows[slot].position.get_position ();
+
+        if (old_position != new_position)
+        {
+            emit_row_moved (old_position, new_position);
+        }
+
+        emit_row_changed (slot);
+    }
+
+    /**
+     * Copy the account details of a freshly-filled row into a stored row,
+     * keeping its failure state, and move it to its sorted position.
+     *
+     * @param slot the slot of the row to update
+     * @param row the new contents of the row
+     */
+    private void update_row (int slot, AccountRow row)
+    {
+        var name_changed = row.display_name != rows[slot].display_name;
+
+        rows[slot].account = row.account;
+        rows[slot].provider = row.provider;
+        rows[slot].display_name = row.display_name;
+        rows[slot].enabled = row.enabled;
+
+        reposition_row (slot, name_changed);
+    }
+
+    /**
+     * Compare two rows according to the current sort order.
+     *
+     * @param a the slot of the first row
+     * @param b the slot of the second row
+     * @return a negative value if a comes before b, a positive value
+     * otherwise
+     */
+    private int compare_rows (int a, int b)
+    {
+        var result = 0;
+
+        switch (current_sort_order)
+        {
+            case SortOrder.PROVIDER:
+                result = strcmp (provider_sort_key (rows[a].provider),
+                                 provider_sort_key (rows[b].provider));
+                if (result == 0)
+                {
+                    result = strcmp (rows[a].name_key, rows[b].name_key);
+                }
+                break;
+            case SortOrder.DISPLAY_NAME:
+                result = strcmp (rows[a].name_key, rows[b].name_key);
+                break;
+            case SortOrder.ENABLED:
+                result = (int) rows[b].enabled - (int) rows[a].enabled;
+                break;
+            case SortOrder.NEEDS_ATTENTION:
+                result = (int) rows[b].attention - (int) rows[a].attention;
+                break;
+            default:
+                break;
+        }
+
+        if (result != 0)
+        {
+            return result;
+        }
+
+        return rows[a].account_id < rows[b].account_id ? -1 : 1;
+    }
+
+    /**
+     * Compare two rows by display name, for the prefix index. PROBE_SLOT
+     * stands for search_key, and sorts before all the names which are equal
+     * to it or have it as a prefix.
+     *
+     * @param a the slot of the first row, or PROBE_SLOT
+     * @param b the slot of the second row, or PROBE_SLOT
+     * @return a negative value if a comes before b, a positive value
+     * otherwise
+     */
+    private int compare_names (int a, int b)
+    {
+        if (a == PROBE_SLOT)
+        {
+            return strcmp (search_key, rows[b].name_key) <= 0 ? -1 : 1;
+        }
+        else if (b == PROBE_SLOT)
+        {
+            return strcmp (search_key, rows[a].name_key) <= 0 ? 1 : -1;
+        }
+
+        var result = strcmp (rows[a].name_key, rows[b].name_key);
+        if (result != 0)
+        {
+            return result;
+        }
+
+        return rows[a].account_id < rows[b].account_id ? -1 : 1;
+    }
+
+    /**
+     * Get the key used to sort and search by account display name.
+     *
+     * @param display_name the display name of an account
+     * @return the key for the display name
+     */
+    private static string make_name_key (string? display_name)
+    {
+        if (display_name == null)
+        {
+            return "";
+        }
+
+        return display_name.normalize ().casefold ();
+    }
+
+    /**
+     * Get the key used to sort by provider display name.
+     *
+     * @param provider the provider of an account, or null for a placeholder
+     * @return the key for the provider
+     */
+    private static unowned string provider_sort_key (ProviderData? provider)
+    {
+        return provider != null ? provider.sort_key : "";
+    }
+
+    /**
+     * Find the accounts whose display name starts with the given prefix,
+     * ignoring case. The lookup uses an index of the display names, so it
+     * only takes time proportional to the number of matches.
+     *
+     * @param prefix the prefix to look up
+     * @return the IDs of the matching accounts, sorted by display name
+     */
+    public uint[] find_accounts_by_prefix (string prefix)
+    {
+        uint[] account_ids = {};
+
+        search_key = make_name_key (prefix);
+        var iter = names.search (PROBE_SLOT, compare_names);
+
+        for (; !iter.is_end (); iter = iter.next ())
+        {
+            var slot = iter.get ();
+            if (!rows[slot].name_key.has_prefix (search_key))
+            {
+                break;
+            }
+
+            account_ids += rows[slot].account_id;
+        }
+
+        search_key = null;
+        return account_ids;
     }
 
     /**
@@ -171,19 +809,176 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
             return;
         }
 
-        /* Insert the new account at the bottom of the list of accounts, but
-         * before the ‘Add account’ row.
+        add_account_row (fill_account_row (account));
+    }
+
+    /**
+     * Add a placeholder row for an account, to be filled in by
+     * populate_batch().
+     *
+     * This method is intended to be used with the foreach method of GLib
+     * containers.
+     *
+     * @param account_id an Ag.AccountId to add to the list of accounts
+     */
+    private void add_placeholder_account (uint account_id)
+    {
+        var row = AccountRow ();
+        row.account_id = account_id;
+        row.enabled = true;
+        row.attention = false;
+
+        add_account_row (row);
+        pending_accounts.push_tail (account_id);
+    }
+
+    /**
+     * Resolve placeholder rows until the time budget for the batch is
+     * exhausted.
+     *
+     * @return true if there are more placeholder rows to resolve
+     */
+    private bool populate_batch ()
+    {
+        var deadline = get_monotonic_time () + POPULATE_BATCH_BUDGET;
+
+        while (!pending_accounts.is_empty ())
+        {
+            var account_id = pending_accounts.pop_head ();
+            resolve_placeholder_account (account_id);
+
+            if (get_monotonic_time () >= deadline)
+            {
+                break;
+            }
+        }
+
+        if (!pending_accounts.is_empty ())
+        {
+            return true;
+        }
+
+        populate_source = 0;
+        populated = true;
+        population_finished ();
+        return false;
+    }
+
+    /**
+     * Load the account for a placeholder row, and fill in the row.
+     *
+     * @param account_id the Ag.AccountId of the placeholder row
+     */
+    private void resolve_placeholder_account (uint account_id)
+    {
+        int slot;
+
+        // The account might have been deleted in the meantime.
+        if (!lookup_row_slot (account_id, out slot))
+        {
+            return;
+        }
+
+        Ag.Account account;
+
+        try
+        {
+            account = accounts_manager.load_account (account_id);
+        }
+        catch (Error error)
+        {
+            critical ("Unable to instantiate account: %s", error.message);
+            remove_account_row (account_id);
+            return;
+        }
+
+        /* The failure state might already be known: keep the
+         * NEEDS_ATTENTION column as it is. */
+        update_row (slot, fill_account_row (account));
+    }
+
+    /**
+     * Add a row for an account to the model, and index it by account ID.
+     *
+     * @param row the contents of the new row
+     */
+    internal void add_account_row (AccountRow row)
+    {
+        int slot;
+
+        // Reuse the slot of a removed row, if there is one.
+        if (free_slots.length > 0)
+        {
+            slot = free_slots[free_slots.length - 1];
+            free_slots.resize (free_slots.length - 1);
+            rows[slot] = row;
+        }
+        else
+        {
+            slot = rows.length;
+            rows += row;
+        }
+
+        account_rows.insert (row.account_id, slot);
+        // The account might have been reported as failing already.
+        rows[slot].attention = row.attention || is_failing (row.account_id);
+        rows[slot].name_key = make_name_key (row.display_name);
+        rows[slot].name_position = names.insert_sorted (slot, compare_names);
+
+        /* Insert the new account at its sorted position in the list of
+         * accounts, always before the ‘Add account’ row.
          */
-        var record = fill_column_record (account_id);
-        insert_with_values (null, this.iter_n_children (null) - 1,
-                            ModelColumns.ACCOUNT_ID, record.account_id,
-                            ModelColumns.ACCOUNT, record.account,
-                            ModelColumns.PROVIDER_ICON, record.icon,
-                            ModelColumns.TRANSLUCENT_PIXBUF, record.translucent_pixbuf,
-                            ModelColumns.ACCOUNT_DESCRIPTION, record.description,
-                            ModelColumns.ENABLED, record.enabled,
-                            ModelColumns.NEEDS_ATTENTION, record.attention,
-                            -1);
+        rows[slot].position = order.insert_sorted (slot, compare_rows);
+
+        var path = new Gtk.TreePath.from_indices (position_of_slot (slot));
+        row_inserted (path, iter_for_slot (slot));
+    }
+
+    /**
+     * Remove the row of an account from the model.
+     *
+     * @param account_id the ID of the account whose row should be removed
+     * @return true if the row was found, false otherwise
+     */
+    private bool remove_account_row (uint account_id)
+    {
+        int slot;
+
+        if (!lookup_row_slot (account_id, out slot))
+        {
+            return false;
+        }
+
+        account_rows.remove (account_id);
+        unsubscribe_account (account_id);
+
+        var position = position_of_slot (slot);
+        Sequence.remove (rows[slot].position);
+        Sequence.remove (rows[slot].name_position);
+        rows[slot] = AccountRow ();
+        free_slots += slot;
+
+        row_deleted (new Gtk.TreePath.from_indices (position));
+        return true;
+    }
+
+    /**
+     * Get the slot of the row of an account.
+     *
+     * @param account_id the ID of the account
+     * @param slot the slot of the row, or -1 if there is no such row
+     * @return true if the account has a row in the model, false otherwise
+     */
+    private bool lookup_row_slot (uint account_id, out int slot)
+    {
+        if (!account_rows.contains (account_id))
+        {
+            slot = -1;
+            return false;
+        }
+
+        slot = account_rows.lookup (account_id);
+        return true;
     }
 
     /**
@@ -200,93 +995,94 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
     public bool find_iter_for_account_id (Ag.AccountId account_id,
                                           out Gtk.TreeIter iter)
     {
-        Gtk.TreeIter local_iter;
-
-        this.get_iter_first (out local_iter);
+        int slot;
 
         // Special-case the "Add account…" row so that it is never changed.
         if (account_id == 0)
         {
-            iter = local_iter;
+            this.get_iter_first (out iter);
             return false;
         }
 
-        var found = false;
-        do
+        if (!lookup_row_slot (account_id, out slot))
         {
-            Ag.AccountId model_account_id;
-            this.get (local_iter, ModelColumns.ACCOUNT_ID, out model_account_id,
-                      -1);
-
-            if (account_id == model_account_id)
-            {
-                found = true;
-                break;
-            }
-        } while (this.iter_next (ref local_iter));
+            iter = Gtk.TreeIter ();
+            return false;
+        }
 
-        iter = local_iter;
-        return found;
+        iter = iter_for_slot (slot);
+        return true;
     }
 
     /**
-     * Create a translucent Gdk.Pixbuf from a GLib.Icon.
+     * Get the provider details shared by the rows of a provider, loading
+     * them if needed.
      *
-     * @param gicon the GLib.Icon to create a translucent pixbuf for
+     * @param provider_name the name of the provider
+     * @return the shared ProviderData
      */
-    private Gdk.Pixbuf translucent_from_gicon (Icon gicon)
+    internal ProviderData get_provider_data (string provider_name)
     {
-        var icon_theme = Gtk.IconTheme.get_default ();
-        
-        try
+        var data = providers.lookup (provider_name);
+        if (data != null)
+        {
+            return data;
+        }
+
+        data = new ProviderData ();
+        data.name = provider_name;
+        var provider = data_catalog.get_provider (provider_name);
+        if (provider == null)
         {
-            var pixbuf = icon_theme.load_icon (gicon.to_string (),
-                                               32, // Size in pixels.
-                                               0); // No lookup flags.
-            var temp_pixbuf = new Gdk.Pixbuf (pixbuf.get_colorspace (),
-                                              true,
-                                              pixbuf.get_bits_per_sample (),
-                                              pixbuf.get_width (),
-                                              pixbuf.get_height ());
-            temp_pixbuf.fill (0);
+            // The provider file was removed, but its accounts are still there.
+            message ("Provider not found for provider name: %s", provider_name);
+            data.display_name = provider_name;
+            data.sort_key = provider_name.collate_key ();
+            data.icon = null;
+            providers.insert (provider_name, data);
+            return data;
+        }
 
-            // Make the icon translucent.
-            pixbuf.composite (temp_pixbuf, 0, 0, pixbuf.get_width (), pixbuf.get_height (), 0.0, 0.0, 1.0, 1.0, Gdk.InterpType.BILINEAR, 255 / 2);
-            return temp_pixbuf;
+        data.display_name = provider.get_display_name ();
+        data.sort_key = data.display_name != null ?
+            data.display_name.collate_key () : "";
+
+        try
+        {
+            data.icon = Icon.new_for_string (provider.get_icon_name ());
         }
-        catch (Error err)
+        catch (Error error)
         {
-            message ("Error loading icon '%s': %s", gicon.to_string (),
-                     err.message);
-            return new Gdk.Pixbuf (Gdk.Colorspace.RGB,
-                                   true, // Has alpha channel.
-                                   8, // Bits per sample.
-                                   32, // Width.
-                                   32); // Height.
+            message ("Error looking up themed provider icon: %s",
+                     error.message);
+            data.icon = null;
         }
+
+        providers.insert (provider_name, data);
+        return data;
     }
 
     /**
-     * Handle D-Bus property changes on the indicator proxy.
-     *
-     * @param changed_properties dictionary of changed property names and
-     * values
-     * @param invalidated_properties array of names of invalidated properties
+     * Reload the provider details after the provider files changed, and
+     * update the rows of the accounts of each provider.
      */
-    private void on_proxy_properties_changed (Variant changed_properties,
-                                              string invalidated_properties[])
+    private void on_data_catalog_changed ()
     {
-        var iter = changed_properties.iterator ();
+        providers.remove_all ();
 
-        Variant change;
-        while ((change = iter.next_value ()) != null)
+        // Repositioning the rows changes the order, so collect them first.
+        int[] slots = {};
+        for (var iter = order.get_begin_iter (); !iter.is_end (); iter = iter.next ())
         {
-            string property_name;
-            change.get ("{sv}", out property_name, null);
+            slots += iter.get ();
+        }
 
-            if (property_name == "Failures")
+        foreach (var slot in slots)
+        {
+            if (rows[slot].provider != null)
             {
-                on_indicator_notify_failures ();
+                rows[slot].provider = get_provider_data (rows[slot].provider.name);
+                reposition_row (slot, false);
             }
         }
     }
@@ -297,36 +1093,107 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
      */
     private void on_indicator_notify_failures ()
     {
-        var failures = indicator.failures;
+        update_failures (indicator.failures);
+    }
+
+    /**
+     * Mark the failing accounts as needing attention, and clear the state of
+     * the accounts which are no longer failing. The new list of failures is
+     * merged with the previous one, so only the accounts whose state changed
+     * are touched.
+     *
+     * @param failures the IDs of the accounts which are currently failing
+     */
+    internal void update_failures (uint[]? failures)
+    {
+        var current_failures = sort_failures (failures);
+        var i = 0;
+        var j = 0;
 
-        if (past_failures == null && failures == null)
+        while (i < past_failures.length || j < current_failures.length)
         {
-            return;
+            if (j == current_failures.length
+                || (i < past_failures.length
+                    && past_failures[i] < current_failures[j]))
+            {
+                set_failure (past_failures[i++], false);
+            }
+            else if (i == past_failures.length
+                     || current_failures[j] < past_failures[i])
+            {
+                set_failure (current_failures[j++], true);
+            }
+            else
+            {
+                // Still failing.
+                i++;
+                j++;
+            }
         }
 
-        /* Vala uses the _TO_POINTER macros to insert bools and uints, so use
-         * direct_hash and direct_equal.
-         */
-        var failures_hash = new HashTable<uint, bool> (direct_hash, direct_equal);
+        past_failures = current_failures;
+    }
+
+    /**
+     * Check whether an account is in the last list of failures.
+     *
+     * @param account_id the ID of the account
+     * @return true if the account is failing, false otherwise
+     */
+    private bool is_failing (uint account_id)
+    {
+        var low = 0;
+        var high = past_failures.length;
 
-        if (past_failures != null)
+        while (low < high)
         {
-            foreach (var past_failure in past_failures)
+            var middle = low + (high - low) / 2;
+            if (past_failures[middle] < account_id)
             {
-                failures_hash.insert (past_failure, false);
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
             }
         }
 
-        if (failures != null)
+        return low < past_failures.length && past_failures[low] == account_id;
+    }
+
+    /**
+     * Sort a list of failing accounts by account ID, and remove duplicates.
+     *
+     * @param failures the IDs of the failing accounts, as reported by the
+     * indicator
+     * @return a sorted copy of the list, without duplicate IDs
+     */
+    private static uint[] sort_failures (uint[]? failures)
+    {
+        if (failures == null || failures.length == 0)
         {
-            foreach (var failure in failures)
+            return {};
+        }
+
+        uint[] sorted = failures;
+        Posix.qsort (sorted, sorted.length, sizeof (uint), (a, b) =>
+        {
+            var first = *((uint*) a);
+            var second = *((uint*) b);
+            return first < second ? -1 : (first > second ? 1 : 0);
+        });
+
+        var length = 1;
+        for (var i = 1; i < sorted.length; i++)
+        {
+            if (sorted[i] != sorted[length - 1])
             {
-                failures_hash.insert (failure, true);
+                sorted[length++] = sorted[i];
             }
         }
+        sorted.resize (length);
 
-        past_failures = failures;
-        failures_hash.foreach (set_failure);
+        return sorted;
     }
 
     /**
@@ -338,11 +1205,15 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
      */
     private void set_failure (uint account_id, bool failure)
     {
-        Gtk.TreeIter iter;
+        int slot;
 
-        if (find_iter_for_account_id (account_id, out iter))
+        if (lookup_row_slot (account_id, out slot))
         {
-            this.set (iter, ModelColumns.NEEDS_ATTENTION, failure, -1);
+            if (rows[slot].attention != failure)
+            {
+                rows[slot].attention = failure;
+                reposition_row (slot, false);
+            }
         }
         else
         {
@@ -372,12 +1243,9 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
     {
         Ag.AccountId account_id = (Ag.AccountId) id;
 
-        Gtk.TreeIter iter;
-        if (find_iter_for_account_id (account_id, out iter))
-        {
-            this.remove (iter);
-        }
-        else
+        pending_updates.remove (account_id);
+
+        if (!remove_account_row (account_id))
         {
             warning ("Account with ID %u was already removed", id);
         }
@@ -390,27 +1258,77 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
      */
     private void on_account_updated (uint id)
     {
-        Ag.AccountId account_id = (Ag.AccountId) id;
+        queue_account_update (id);
+    }
+
+    /**
+     * Schedule an update of the row of an account. Storing an account can
+     * emit several account-updated signals in a row, so the updates received
+     * before the main loop gets idle are merged.
+     *
+     * @param account_id the ID of the Ag.Account that was updated
+     */
+    internal void queue_account_update (uint account_id)
+    {
+        updates_received++;
+        pending_updates.add (account_id);
 
-        Gtk.TreeIter iter;
-        if (find_iter_for_account_id (account_id, out iter))
+        if (update_source == 0)
         {
-            // Unconditionally copy the data from the changed account.
-            var record = fill_column_record (account_id);
-            this.set (iter,
-                      ModelColumns.PROVIDER_ICON, record.icon,
-                      ModelColumns.TRANSLUCENT_PIXBUF, record.translucent_pixbuf, 
-                      ModelColumns.ACCOUNT_DESCRIPTION, record.description,
-                      ModelColumns.ENABLED, record.enabled,
-                      ModelColumns.NEEDS_ATTENTION, record.attention,
-                      -1);
+            update_source = Idle.add (update_accounts);
         }
-        else
+    }
+
+    /**
+     * Apply the pending account updates.
+     *
+     * @return false, to remove the idle source
+     */
+    private bool update_accounts ()
+    {
+        update_source = 0;
+
+        var account_ids = pending_updates.get_keys ();
+        pending_updates.remove_all ();
+
+        foreach (var account_id in account_ids)
+        {
+            update_account ((Ag.AccountId) account_id);
+        }
+
+        return false;
+    }
+
+    /**
+     * Copy the data from a changed account into its row, if anything changed.
+     *
+     * @param account_id the Ag.AccountId of the Ag.Account that was updated
+     */
+    private void update_account (Ag.AccountId account_id)
+    {
+        int slot;
+        if (!lookup_row_slot (account_id, out slot))
         {
             warning ("Account with ID %u was updated, but did not already exist in the model",
-                     id);
+                     account_id);
             add_account (account_id);
+            return;
+        }
+
+        /* The provider data is shared, so it can be compared by reference.
+         * The failure state is tracked separately, through the indicator,
+         * and is not touched here. */
+        var row = fill_account_row (accounts_manager.get_account (account_id));
+        if (row.account == rows[slot].account
+            && row.provider == rows[slot].provider
+            && row.display_name == rows[slot].display_name
+            && row.enabled == rows[slot].enabled)
+        {
+            return;
         }
+
+        updates_applied++;
+        update_row (slot, row);
     }
 
     /**
@@ -432,18 +1350,13 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
             return;
         }
 
-        Gtk.TreeIter iter;
-        bool model_enabled;
-        if (find_iter_for_account_id (account.id, out iter))
+        int slot;
+        if (lookup_row_slot (account.id, out slot))
         {
-            this.get (iter, ModelColumns.ENABLED, out model_enabled);
-
-            if (model_enabled != enabled)
+            if (rows[slot].enabled != enabled)
             {
-                this.set (iter,
-                          ModelColumns.ACCOUNT_DESCRIPTION, format_account_description (account),
-                          ModelColumns.ENABLED, enabled,
-                          -1);
+                rows[slot].enabled = enabled;
+                reposition_row (slot, false);
             }
         }
         else
@@ -462,12 +1375,11 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
     private void on_account_display_name_changed (Ag.Account account)
     {
 
-        Gtk.TreeIter iter;
-        if (find_iter_for_account_id (account.id, out iter))
+        int slot;
+        if (lookup_row_slot (account.id, out slot))
         {
-            this.set (iter,
-                      ModelColumns.ACCOUNT_DESCRIPTION, format_account_description (account),
-                      -1);
+            rows[slot].display_name = account.get_display_name ();
+            reposition_row (slot, true);
         }
         else
         {
@@ -477,63 +1389,102 @@ public class Cc.Credentials.AccountsModel : Gtk.ListStore
     }
 
     /**
-     * Fill in a ColumnRecord structure with details of the account, for using
+     * Fill in an AccountRow structure with details of the account, for using
      * to fill in a row in the model.
      *
-     * @param account_id the ID of the Ag.Account
-     * @return a new ColumnRecord
+     * Ag.Manager only keeps weak references to the accounts, so the account
+     * is passed in by the caller which loaded it, rather than looked up again.
+     *
+     * @param account the Ag.Account
+     * @return a new AccountRow
      */
-    private ColumnRecord fill_column_record (uint account_id)
+    private AccountRow fill_account_row (Ag.Account account)
     {
-        var account = accounts_manager.get_account ((Ag.AccountId) account_id);
-
-        var record = ColumnRecord ();
+        var row = AccountRow ();
         // FIXME: Add provider property to Ag.Account, and use it here.
-        var display_name = account.get_display_name ();
-        record.enabled = account.get_enabled ();
-        var name_markup = record.enabled ? display_name :
-            "<span foreground=\"#555555\">" + display_name + "</span>";
-        var provider = manager.get_provider (account.get_provider_name ());
-        record.account_id = account_id;
-        record.account = account;
+        row.account_id = account.id;
+        row.account = account;
+        row.provider = get_provider_data (account.get_provider_name ());
+        row.display_name = account.get_display_name ();
+        row.enabled = account.get_enabled ();
+        row.attention = false;
 
-        try
-        {
-            record.icon = Icon.new_for_string (provider.get_icon_name ());
-        }
-        catch (Error error)
+        subscribe_account (account);
+
+        return row;
+    }
+
+    /**
+     * Connect to the signals of an account, unless this was already done for
+     * the same Ag.Account instance.
+     *
+     * @param account the account to monitor
+     */
+    private void subscribe_account (Ag.Account account)
+    {
+        var subscription = account_subscriptions.lookup (account.id);
+        if (subscription != null)
         {
-            message ("Error looking up themed provider icon: %s",
-                     error.message);
-            record.icon = null;
-        }
+            if (subscription.account == account)
+            {
+                return;
+            }
 
-        record.translucent_pixbuf = translucent_from_gicon (record.icon);
+            unsubscribe_account (account.id);
+        }
 
-        // Also see format_account_description ().
-        record.description = provider.get_display_name () + "\n"
-                             + "<small>" + name_markup + "</small>";
-        record.attention = false;
+        subscription = new AccountSubscription ();
+        subscription.account = account;
+        subscription.enabled_handler =
+            account.enabled.connect (on_account_enabled);
+        subscription.display_name_changed_handler =
+            account.display_name_changed.connect (on_account_display_name_changed);
+        account_subscriptions.insert (account.id, subscription);
+    }
 
-        account.enabled.connect (on_account_enabled);
-        account.display_name_changed.connect (on_account_display_name_changed);
+    /**
+     * Disconnect from the signals of an account, if they were connected.
+     *
+     * @param account_id the ID of the account whose row was removed
+     */
+    private void unsubscribe_account (uint account_id)
+    {
+        var subscription = account_subscriptions.lookup (account_id);
+        if (subscription == null)
+        {
+            return;
+        }
 
-        return record;
+        SignalHandler.disconnect (subscription.account,
+                                  subscription.enabled_handler);
+        SignalHandler.disconnect (subscription.account,
+                                  subscription.display_name_changed_handler);
+        account_subscriptions.remove (account_id);
     }
 
     /**
      * Provide a string describing the account for display to the user.
      *
-     * @param account the account for which to generate the description
+     * @param provider the provider of the account, or null for a placeholder
+     * @param display_name the display name of the account
+     * @param enabled whether the account is enabled
      * @return the account description
      */
-    private string format_account_description (Ag.Account account)
+    private static string format_account_description (ProviderData? provider,
+                                                      string? display_name,
+                                                      bool enabled)
     {
-        var provider = manager.get_provider (account.get_provider_name ());
-        var display_name = account.get_display_name ();
-        var name_markup = account.get_enabled () ? display_name :
-            "<span foreground=\"#555555\">" + display_name + "</span>";
-        return provider.get_display_name () + "\n"
+        if (provider == null && display_name == null)
+        {
+            return "";
+        }
+
+        var name = display_name ?? "";
+        var name_markup = enabled ? name :
+            "<span foreground=\"#555555\">" + name + "</span>";
+        var provider_display_name = provider != null ? provider.display_name
+                                                     : "";
+        return provider_display_name + "\n"
                + "<small>" + name_markup + "</small>";
     }
 }
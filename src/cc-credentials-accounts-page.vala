@@ -28,6 +28,9 @@ public class Cc.Credentials.AccountsPage : Gtk.Grid
 
     private Gtk.TreeView accounts_tree;
     private AccountsModel accounts_store;
+    /* The accounts matching the last type-ahead search key. */
+    private HashTable<uint, bool> search_matches;
+    private string? search_matches_key;
     private Gtk.Notebook accounts_notebook;
     private AccountDetailsPage account_details_page;
 
@@ -142,10 +145,12 @@ public class Cc.Credentials.AccountsPage : Gtk.Grid
     private Gtk.Widget create_accounts_tree ()
     {
         accounts_tree = new Gtk.TreeView ();
-        accounts_store = new AccountsModel ();
+        accounts_store = new AccountsModel (true);
 
         accounts_tree.model = accounts_store;
         accounts_tree.headers_visible = false;
+        accounts_tree.search_column = AccountsModel.ModelColumns.ACCOUNT_DESCRIPTION;
+        accounts_tree.set_search_equal_func (accounts_search_equal_func);
 
         var provider_icon_renderer = new Gtk.CellRendererPixbuf ();
         provider_icon_renderer.stock_size = Gtk.IconSize.DND;
@@ -199,6 +204,7 @@ public class Cc.Credentials.AccountsPage : Gtk.Grid
 
         // Check if any changes occured on the selected row.
         accounts_store.row_changed.connect (on_accounts_store_row_changed);
+        accounts_store.row_deleted.connect (on_accounts_store_row_deleted);
 
         // The changed handler depends on the notebook being constructed.
         accounts_selection.changed.connect (on_accounts_selection_changed);
@@ -261,6 +267,40 @@ public class Cc.Credentials.AccountsPage : Gtk.Grid
         return account_details_page;
     }
 
+    /**
+     * Match the rows of the accounts tree against the type-ahead search key.
+     * The accounts whose display name starts with the key are looked up once
+     * for each key, rather than formatting the description of every row.
+     *
+     * @param model the AccountsModel being searched
+     * @param column the search column. Unused
+     * @param key the text typed by the user
+     * @param iter the row to check
+     * @return false if the row matches, true otherwise
+     */
+    private bool accounts_search_equal_func (Gtk.TreeModel model,
+                                             int column,
+                                             string key,
+                                             Gtk.TreeIter iter)
+    {
+        if (key != search_matches_key)
+        {
+            search_matches = new HashTable<uint, bool> (direct_hash,
+                                                        direct_equal);
+            foreach (var account_id in accounts_store.find_accounts_by_prefix (key))
+            {
+                search_matches.add (account_id);
+            }
+            search_matches_key = key;
+        }
+
+        uint account_id;
+        model.get (iter, AccountsModel.ModelColumns.ACCOUNT_ID, out account_id,
+                   -1);
+
+        return !search_matches.contains (account_id);
+    }
+
     /**
      * Show the translucent provider icon if the account is disabled, and the
      * standard icon when the account is enabled.
@@ -311,6 +351,9 @@ public class Cc.Credentials.AccountsPage : Gtk.Grid
     {
         var selection = accounts_tree.get_selection ();
 
+        // The display name of the account might have changed.
+        search_matches_key = null;
+
         if (selection.path_is_selected (path))
         {
             // Set the selected iter again.
@@ -421,7 +464,20 @@ public class Cc.Credentials.AccountsPage : Gtk.Grid
     private void on_accounts_store_row_inserted (Gtk.TreePath path,
                                                  Gtk.TreeIter iter)
     {
+        // The new account was not searched for yet.
+        search_matches_key = null;
+
         var selection = accounts_tree.get_selection ();
         selection.select_iter (iter);
     }
+
+    /**
+     * Drop the cached search matches when an account is removed.
+     *
+     * @param path the Gtk.TreePath of the removed row
+     */
+    private void on_accounts_store_row_deleted (Gtk.TreePath path)
+    {
+        search_matches_key = null;
+    }
 }
@@ -25,7 +25,8 @@
  */
 public class Cc.Credentials.ApplicationsModel : Gtk.ListStore
 {
-    private Ag.Manager manager;
+    private DataCatalog data_catalog;
+    private ProvidersModel providers_model;
 
     /**
      * Identifiers for columns in the applications model.
@@ -42,34 +43,82 @@ public class Cc.Credentials.ApplicationsModel : Gtk.ListStore
 
     /**
      * Create a new data model for the list of applications.
+     *
+     * @param data_catalog the catalog to list the applications from, or null
+     * for the default catalog
+     */
+    public ApplicationsModel (DataCatalog? data_catalog = null)
+    {
+        Type[] types = { typeof (string), typeof (string) };
+        set_column_types (types);
+
+        this.data_catalog = data_catalog ?? DataCatalog.get_default ();
+
+        populate_model ();
+
+        this.data_catalog.changed.connect (update_model);
+    }
+
+    /**
+     * Create a new data model for the list of applications, listing the
+     * applications stored in the catalog of a providers model, so that the
+     * data files are not parsed when the catalog is up to date.
+     *
+     * @param providers_model the providers model to list the applications
+     * from
      */
-    public ApplicationsModel ()
+    public ApplicationsModel.with_providers_model (ProvidersModel providers_model)
     {
         Type[] types = { typeof (string), typeof (string) };
         set_column_types (types);
 
-        // TODO: Use the same Ag.Manager throughout.
-        manager = new Ag.Manager ();
+        this.providers_model = providers_model;
 
         populate_model ();
 
-        // FIXME: No notification signals for adding new applications.
+        providers_model.applications_changed.connect (update_model);
     }
 
     /**
-     * Populate the model with the current list of applications, by querying
-     * for available services and then listing the applications available for
-     * each service.
+     * Populate the model with the current list of applications.
      */
     private void populate_model ()
     {
-        var services = manager.list_services ();
+        list_applications ().foreach (add_application);
+
+        // Magic value! Must always be the first item in the list.
+        insert_with_values (null, 0,
+                            ModelColumns.APPLICATION_NAME, "all",
+                            ModelColumns.APPLICATION_DESCRIPTION, _("All applications"));
+    }
+
+    /**
+     * List the applications available for the current services, from the
+     * providers model if there is one.
+     *
+     * @return a table of application descriptions, keyed by application name
+     */
+    private HashTable<string, string> list_applications ()
+    {
         var application_hash = new HashTable<string, string> (str_hash,
                                                               str_equal);
 
+        if (providers_model != null)
+        {
+            foreach (var application in providers_model.get_applications ())
+            {
+                application_hash.insert (application.name,
+                                         application.description);
+            }
+
+            return application_hash;
+        }
+
+        var services = data_catalog.list_services ();
+
         foreach (var service in services)
         {
-            var applications = manager.list_applications_by_service (service);
+            var applications = data_catalog.list_applications_by_service (service);
 
             foreach (var application in applications)
             {
@@ -80,12 +129,56 @@ public class Cc.Credentials.ApplicationsModel : Gtk.ListStore
             }
         }
 
-        application_hash.foreach (add_application);
+        return application_hash;
+    }
 
-        // Magic value! Must always be the first item in the list.
-        insert_with_values (null, 0,
-                            ModelColumns.APPLICATION_NAME, "all",
-                            ModelColumns.APPLICATION_DESCRIPTION, _("All applications"));
+    /**
+     * Update the model after the libaccounts data files changed, removing
+     * the rows of applications which are gone and adding rows for new
+     * applications, without touching the other rows.
+     */
+    private void update_model ()
+    {
+        var application_hash = list_applications ();
+
+        Gtk.TreeIter iter;
+        if (!get_iter_first (out iter))
+        {
+            return;
+        }
+
+        // Skip the "all" row.
+        var valid = iter_next (ref iter);
+        while (valid)
+        {
+            string application_name;
+            string application_description;
+            this.get (iter,
+                      ModelColumns.APPLICATION_NAME, out application_name,
+                      ModelColumns.APPLICATION_DESCRIPTION, out application_description,
+                      -1);
+
+            if (application_hash.contains (application_name))
+            {
+                var new_description = application_hash.lookup (application_name);
+                if (new_description != application_description)
+                {
+                    this.set (iter,
+                              ModelColumns.APPLICATION_DESCRIPTION, new_description,
+                              -1);
+                }
+
+                application_hash.remove (application_name);
+                valid = iter_next (ref iter);
+            }
+            else
+            {
+                // Removing the row moves the iter to the next row.
+                valid = remove (ref iter);
+            }
+        }
+
+        application_hash.foreach (add_application);
     }
 
     /**
@@ -25,10 +25,14 @@
 public class Cc.Credentials.AuthorizationPage : Gtk.Grid
 {
     private Ap.Plugin plugin;
+    private Cancellable plugin_cancellable;
     private weak Gtk.Widget widget;
     private Ag.Account current_account;
-    private WebcredentialsIndicator indicator;
+    private WebcredentialsIndicatorClient indicator;
     private bool needs_reauthentication = false;
+    private string login_username;
+    private string? login_password;
+    private HashTable<string,string>? login_cookies;
 
     /**
      * Emitted when the authorization process was cancelled.
@@ -48,33 +52,20 @@ public class Cc.Credentials.AuthorizationPage : Gtk.Grid
         {
             current_account = value;
 
-            plugin = Ap.client_load_plugin (account);
-            if (plugin == null)
+            if (plugin != null)
             {
-                critical ("No valid plugin found for provider %s",
-                          value.get_provider_name ());
-                return;
+                plugin.finished.disconnect (on_plugin_finished);
+                plugin = null;
             }
-
-            plugin.finished.connect (on_plugin_finished);
-
-            if (needs_reauthentication)
+            // The widget of the old plugin must not be used meanwhile.
+            remove_plugin_widget ();
+            login_username = null;
+            if (plugin_cancellable != null)
             {
-                plugin.need_authentication = true;
-            }
-
-            var plugin_widget = plugin.build_widget ();
-
-            if (plugin_widget != null)
-            {
-                set_plugin_widget (plugin.build_widget ());
-            }
-            else
-            {
-                critical ("Plugin failed to build widget for account ID: %u",
-                          value.id);
-                return;
+                plugin_cancellable.cancel ();
             }
+            plugin_cancellable = new Cancellable ();
+            load_plugin.begin (value, plugin_cancellable);
         }
     }
 
@@ -88,16 +79,7 @@ public class Cc.Credentials.AuthorizationPage : Gtk.Grid
         expand = true;
         orientation = Gtk.Orientation.VERTICAL;
 
-        try
-        {
-            indicator = Bus.get_proxy_sync (BusType.SESSION,
-                                            "com.canonical.indicators.webcredentials",
-                                            "/com/canonical/indicators/webcredentials");
-        }
-        catch (IOError err)
-        {
-            warning ("Error initializing indicator proxy: %s\nAccount attention notifications will not function", err.message);
-        }
+        indicator = WebcredentialsIndicatorClient.get_default ();
 
         show ();
     }
@@ -125,6 +107,15 @@ public class Cc.Credentials.AuthorizationPage : Gtk.Grid
                                 string? password,
                                 HashTable<string,string>? cookies)
     {
+        if (plugin == null)
+        {
+            /* The plugin is still being loaded. */
+            login_username = username;
+            login_password = password;
+            login_cookies = cookies;
+            return;
+        }
+
         plugin.set_credentials (username, password);
         if (cookies != null)
         {
@@ -132,6 +123,75 @@ public class Cc.Credentials.AuthorizationPage : Gtk.Grid
         }
     }
 
+    /**
+     * Load the account plugin in the background, and show its widget.
+     *
+     * @param account the account to authorize
+     * @param cancellable cancelled when a different account is set
+     */
+    private async void load_plugin (Ag.Account account,
+                                    Cancellable cancellable)
+    {
+        Ap.Plugin loaded_plugin = null;
+
+        try
+        {
+            // The plugin is used interactively, so it must not be shared.
+            loaded_plugin = yield PluginCache.get_default ().load_fresh_async (account,
+                                                                               cancellable);
+        }
+        catch (IOError.CANCELLED error)
+        {
+            return;
+        }
+        catch (Error error)
+        {
+            warning ("Error loading plugin for provider %s: %s",
+                     account.get_provider_name (), error.message);
+        }
+
+        if (cancellable.is_cancelled ())
+        {
+            return;
+        }
+
+        if (loaded_plugin == null)
+        {
+            critical ("No valid plugin found for provider %s",
+                      account.get_provider_name ());
+            return;
+        }
+
+        plugin = loaded_plugin;
+        plugin.finished.connect (on_plugin_finished);
+
+        if (needs_reauthentication)
+        {
+            plugin.need_authentication = true;
+        }
+
+        var plugin_widget = plugin.build_widget ();
+
+        if (plugin_widget != null)
+        {
+            set_plugin_widget (plugin_widget);
+        }
+        else
+        {
+            critical ("Plugin failed to build widget for account ID: %u",
+                      account.id);
+            return;
+        }
+
+        if (login_username != null)
+        {
+            set_login_data (login_username, login_password, login_cookies);
+            login_username = null;
+            login_password = null;
+            login_cookies = null;
+        }
+    }
+
     /**
      * Set a plugin widget and show it, removing the old widget if necessary.
      *
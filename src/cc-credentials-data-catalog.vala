@@ -0,0 +1,222 @@
+/*
+ * Copyright 2012 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * The Ag.Manager shared by the models and pages of the panel, together with
+ * a cache of the providers, services and applications that it lists. Each
+ * Ag.Manager opens the accounts database and subscribes to the D-Bus change
+ * notifications of libaccounts, and libaccounts parses the data files again
+ * for every listing, so they are only done once per process. The cache is
+ * dropped when the DataMonitor reports changes to the data files.
+ */
+public class Cc.Credentials.DataCatalog : Object
+{
+    private static DataCatalog default_catalog;
+    private List<Ag.Provider> providers;
+    private List<Ag.Service> services;
+    private bool providers_listed = false;
+    private bool services_listed = false;
+    private HashTable<string, Ag.Provider> providers_by_name;
+    private HashTable<string, ServiceApplications> applications_by_service;
+    /* Serializes the lookups of desktop files. */
+    private Mutex desktop_info_mutex = Mutex ();
+
+    /**
+     * The applications which integrate with one service.
+     */
+    private class ServiceApplications
+    {
+        public List<Ag.Application> applications;
+    }
+
+    /**
+     * The account manager, for loading and creating accounts.
+     */
+    public Ag.Manager manager { get; construct; }
+
+    /**
+     * The number of times that the services were listed by the account
+     * manager.
+     */
+    public uint services_listed_count { get; private set; default = 0; }
+
+    /**
+     * Emitted after the cache was dropped because the data files changed.
+     */
+    public signal void changed ();
+
+    /**
+     * Get the catalog shared by the whole process.
+     *
+     * @return the default DataCatalog
+     */
+    public static DataCatalog get_default ()
+    {
+        if (default_catalog == null)
+        {
+            default_catalog = new DataCatalog ();
+        }
+
+        return default_catalog;
+    }
+
+    /**
+     * Create a catalog with a new account manager. Use get_default () rather
+     * than this, so that the account manager is shared.
+     */
+    public DataCatalog ()
+    {
+        Object (manager: new Ag.Manager ());
+    }
+
+    /**
+     * Create a catalog for an existing account manager.
+     *
+     * @param manager the account manager to use
+     */
+    public DataCatalog.with_manager (Ag.Manager manager)
+    {
+        Object (manager: manager);
+    }
+
+    construct
+    {
+        providers_by_name = new HashTable<string, Ag.Provider> (str_hash,
+                                                                str_equal);
+        applications_by_service =
+            new HashTable<string, ServiceApplications> (str_hash, str_equal);
+
+        DataMonitor.get_default ().changed.connect (on_data_monitor_changed);
+    }
+
+    /**
+     * Drop the cache when the data files change, and tell the users of the
+     * catalog to update themselves.
+     */
+    private void on_data_monitor_changed ()
+    {
+        providers = null;
+        services = null;
+        providers_listed = false;
+        services_listed = false;
+        providers_by_name.remove_all ();
+        applications_by_service.remove_all ();
+
+        changed ();
+    }
+
+    /**
+     * List the installed providers.
+     *
+     * @return the cached list of providers, which must not be modified
+     */
+    public unowned List<Ag.Provider> list_providers ()
+    {
+        if (!providers_listed)
+        {
+            providers = manager.list_providers ();
+            providers_listed = true;
+        }
+
+        return providers;
+    }
+
+    /**
+     * Get a provider by name.
+     *
+     * @param provider_name the name of the provider
+     * @return the provider, or null if it is not installed
+     */
+    public Ag.Provider? get_provider (string provider_name)
+    {
+        var provider = providers_by_name.lookup (provider_name);
+        if (provider == null)
+        {
+            provider = manager.get_provider (provider_name);
+            if (provider != null)
+            {
+                providers_by_name.insert (provider_name, provider);
+            }
+        }
+
+        return provider;
+    }
+
+    /**
+     * List the installed services.
+     *
+     * @return the cached list of services, which must not be modified
+     */
+    public unowned List<Ag.Service> list_services ()
+    {
+        if (!services_listed)
+        {
+            services = manager.list_services ();
+            services_listed = true;
+            services_listed_count++;
+        }
+
+        return services;
+    }
+
+    /**
+     * Get a service by name. Ag.Manager already caches services.
+     *
+     * @param service_name the name of the service
+     * @return the service, or null if it is not installed
+     */
+    public Ag.Service? get_service (string service_name)
+    {
+        return manager.get_service (service_name);
+    }
+
+    /**
+     * Get the desktop file of an application. Ag.Application loads it on
+     * first use, without locking, so every lookup must go through this when
+     * worker threads are involved.
+     *
+     * @param application the application
+     * @return the desktop file information, or null if there is none
+     */
+    public DesktopAppInfo? get_desktop_app_info (Ag.Application application)
+    {
+        desktop_info_mutex.lock ();
+        var desktop_info = application.get_desktop_app_info ();
+        desktop_info_mutex.unlock ();
+
+        return desktop_info;
+    }
+
+    /**
+     * List the applications which integrate with a service.
+     *
+     * @param service the service
+     * @return the cached list of applications, which must not be modified
+     */
+    public unowned List<Ag.Application> list_applications_by_service (Ag.Service service)
+    {
+        var service_name = service.get_name ();
+        var service_applications = applications_by_service.lookup (service_name);
+        if (service_applications == null)
+        {
+            service_applications = new ServiceApplications ();
+            service_applications.applications = manager.list_applications_by_service (service);
+            applications_by_service.insert (service_name, service_applications);
+        }
+
+        return service_applications.applications;
+    }
+}
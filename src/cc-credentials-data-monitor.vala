@@ -0,0 +1,164 @@
+/*
+ * Copyright 2012 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Monitor of the directories holding the libaccounts data files, the desktop
+ * files and the account plugins. Installing a package usually touches many
+ * files in a row, so the file change notifications are merged, and changed
+ * is only emitted once the directories have been quiet for a while.
+ */
+public class Cc.Credentials.DataMonitor : Object
+{
+    private static DataMonitor default_monitor;
+    private FileMonitor[] monitors = {};
+    private uint debounce_interval;
+    private uint debounce_source = 0;
+
+    /**
+     * The default time to wait for more changes before emitting changed, in
+     * milliseconds.
+     */
+    public const uint DEFAULT_DEBOUNCE_INTERVAL = 500;
+
+    /**
+     * The number of file change notifications received.
+     */
+    public uint events_received { get; private set; default = 0; }
+
+    /**
+     * The number of times that changed was emitted.
+     */
+    public uint batches_emitted { get; private set; default = 0; }
+
+    /**
+     * Emitted once a batch of changes to the monitored directories is
+     * complete.
+     */
+    public signal void changed ();
+
+    /**
+     * Get the monitor shared by the whole process, watching the directories
+     * which ProvidersModel and ApplicationsModel are built from.
+     *
+     * @return the default DataMonitor
+     */
+    public static DataMonitor get_default ()
+    {
+        if (default_monitor == null)
+        {
+            var directories = ProvidersCatalog.get_source_directories ();
+            directories += Ap.client_get_application_plugin_dir ();
+            default_monitor = new DataMonitor (directories,
+                                               DEFAULT_DEBOUNCE_INTERVAL);
+            default_monitor.changed.connect (() =>
+            {
+                // Plugins might have been installed after a failed lookup.
+                Ap.client_invalidate_plugin_types (null);
+            });
+        }
+
+        return default_monitor;
+    }
+
+    /**
+     * Create a monitor for the given directories. Directories which do not
+     * exist yet are monitored for creation.
+     *
+     * @param directories the paths of the directories to monitor
+     * @param debounce_interval the time to wait for more changes before
+     * emitting changed, in milliseconds
+     */
+    public DataMonitor (string[] directories, uint debounce_interval)
+    {
+        this.debounce_interval = debounce_interval;
+
+        foreach (var directory in directories)
+        {
+            try
+            {
+                var monitor = File.new_for_path (directory).monitor_directory (FileMonitorFlags.NONE);
+                monitor.changed.connect (on_monitor_changed);
+                monitors += monitor;
+            }
+            catch (Error error)
+            {
+                message ("Error monitoring directory %s: %s",
+                         directory, error.message);
+            }
+        }
+    }
+
+    ~DataMonitor ()
+    {
+        if (debounce_source != 0)
+        {
+            Source.remove (debounce_source);
+        }
+
+        foreach (var monitor in monitors)
+        {
+            monitor.cancel ();
+        }
+    }
+
+    /**
+     * Handle a change in one of the monitored directories, by restarting the
+     * debounce timeout.
+     *
+     * @param file the file which changed
+     * @param other_file the new name of the file, if it was moved
+     * @param event_type the type of change
+     */
+    private void on_monitor_changed (File file,
+                                     File? other_file,
+                                     FileMonitorEvent event_type)
+    {
+        switch (event_type)
+        {
+            case FileMonitorEvent.CREATED:
+            case FileMonitorEvent.DELETED:
+            case FileMonitorEvent.CHANGES_DONE_HINT:
+            case FileMonitorEvent.MOVED:
+                break;
+            default:
+                // Wait for the changes to be done.
+                return;
+        }
+
+        events_received++;
+
+        if (debounce_source != 0)
+        {
+            Source.remove (debounce_source);
+        }
+        debounce_source = Timeout.add (debounce_interval, on_debounce_timeout);
+    }
+
+    /**
+     * Emit changed once the directories have been quiet for the debounce
+     * interval.
+     *
+     * @return false, to remove the timeout source
+     */
+    private bool on_debounce_timeout ()
+    {
+        debounce_source = 0;
+        batches_emitted++;
+        changed ();
+
+        return false;
+    }
+}
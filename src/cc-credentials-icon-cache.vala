@@ -0,0 +1,169 @@
+/*
+ * Copyright 2012 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Cache of the translucent icons shown for disabled accounts. Many accounts
+ * share the same provider icon, so the translucent pixbuf is only composited
+ * once for each icon name, size and scale, and then shared between rows. The
+ * cache is flushed when the icon theme changes.
+ */
+public class Cc.Credentials.TranslucentIconCache : Object
+{
+    private static TranslucentIconCache default_cache;
+    private Gtk.IconTheme icon_theme;
+    private HashTable<string, Gdk.Pixbuf> pixbufs;
+    private uint n_hits = 0;
+    private uint n_misses = 0;
+
+    /**
+     * The number of lookups answered from the cache.
+     */
+    public uint hits
+    {
+        get
+        {
+            return n_hits;
+        }
+    }
+
+    /**
+     * The number of lookups which required compositing a new pixbuf.
+     */
+    public uint misses
+    {
+        get
+        {
+            return n_misses;
+        }
+    }
+
+    /**
+     * The fraction of lookups answered from the cache, for debugging.
+     */
+    public double hit_ratio
+    {
+        get
+        {
+            var lookups = n_hits + n_misses;
+            return lookups == 0 ? 0.0 : (double) n_hits / lookups;
+        }
+    }
+
+    /**
+     * Get the cache shared by all the accounts models.
+     *
+     * @return the default TranslucentIconCache
+     */
+    public static TranslucentIconCache get_default ()
+    {
+        if (default_cache == null)
+        {
+            default_cache = new TranslucentIconCache (Gtk.IconTheme.get_default ());
+        }
+
+        return default_cache;
+    }
+
+    /**
+     * Create a new cache for icons loaded from the given theme.
+     *
+     * @param icon_theme the Gtk.IconTheme to load icons from
+     */
+    public TranslucentIconCache (Gtk.IconTheme icon_theme)
+    {
+        this.icon_theme = icon_theme;
+        pixbufs = new HashTable<string, Gdk.Pixbuf> (str_hash, str_equal);
+        icon_theme.changed.connect (flush);
+    }
+
+    ~TranslucentIconCache ()
+    {
+        icon_theme.changed.disconnect (flush);
+    }
+
+    /**
+     * Get a translucent Gdk.Pixbuf for a GLib.Icon. The returned pixbuf is
+     * shared, and must not be modified.
+     *
+     * @param gicon the GLib.Icon to create a translucent pixbuf for
+     * @param size the icon size, in pixels
+     * @param scale the scale factor of the display
+     * @return the translucent pixbuf
+     */
+    public Gdk.Pixbuf lookup (Icon? gicon, int size, int scale)
+    {
+        var icon_name = gicon != null ? gicon.to_string () : "";
+        var key = "%s:%d:%d".printf (icon_name, size, scale);
+
+        var pixbuf = pixbufs.lookup (key);
+        if (pixbuf != null)
+        {
+            n_hits++;
+            return pixbuf;
+        }
+
+        n_misses++;
+        pixbuf = translucent_from_icon_name (icon_name, size * scale);
+        pixbufs.insert (key, pixbuf);
+        return pixbuf;
+    }
+
+    /**
+     * Drop all the cached pixbufs.
+     */
+    public void flush ()
+    {
+        debug ("Flushing translucent icon cache: %u hits, %u misses (%.0f%%)",
+               n_hits, n_misses, hit_ratio * 100);
+        pixbufs.remove_all ();
+    }
+
+    /**
+     * Create a translucent Gdk.Pixbuf from a themed icon.
+     *
+     * @param icon_name the name of the themed icon
+     * @param pixel_size the size of the pixbuf, in pixels
+     */
+    private Gdk.Pixbuf translucent_from_icon_name (string icon_name,
+                                                   int pixel_size)
+    {
+        try
+        {
+            var pixbuf = icon_theme.load_icon (icon_name,
+                                               pixel_size,
+                                               0); // No lookup flags.
+            var temp_pixbuf = new Gdk.Pixbuf (pixbuf.get_colorspace (),
+                                              true,
+                                              pixbuf.get_bits_per_sample (),
+                                              pixbuf.get_width (),
+                                              pixbuf.get_height ());
+            temp_pixbuf.fill (0);
+
+            // Make the icon translucent.
+            pixbuf.composite (temp_pixbuf, 0, 0, pixbuf.get_width (), pixbuf.get_height (), 0.0, 0.0, 1.0, 1.0, Gdk.InterpType.BILINEAR, 255 / 2);
+            return temp_pixbuf;
+        }
+        catch (Error err)
+        {
+            message ("Error loading icon '%s': %s", icon_name, err.message);
+            return new Gdk.Pixbuf (Gdk.Colorspace.RGB,
+                                   true, // Has alpha channel.
+                                   8, // Bits per sample.
+                                   pixel_size, // Width.
+                                   pixel_size); // Height.
+        }
+    }
+}
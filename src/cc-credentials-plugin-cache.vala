@@ -0,0 +1,187 @@
+/*
+ * Copyright 2012 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Cache of account plugins, keyed by account ID. Constructing a plugin
+ * loads its module and, for OAuth plugins, fetches the authentication data
+ * of the account, so the pages share one instance per account for uses
+ * which do not change the state of the plugin, such as checking whether it
+ * has a configuration widget or deleting the account. Interactive flows,
+ * which show the widget of the plugin and wait for it to finish, get fresh
+ * instances. Plugins are evicted when their account is updated or deleted,
+ * and when there are more than max_size of them.
+ */
+public class Cc.Credentials.PluginCache : Object
+{
+    private static PluginCache default_cache;
+    private HashTable<uint, Ap.Plugin> plugins;
+    /* Account IDs of the cached plugins, most recently used first. */
+    private Queue<uint> plugin_order;
+
+    /**
+     * The default number of plugins kept in the cache.
+     */
+    public const uint DEFAULT_MAX_SIZE = 4;
+
+    /**
+     * The maximum number of plugins kept in the cache.
+     */
+    public uint max_size { get; construct; }
+
+    /**
+     * The number of plugins constructed, shared or not.
+     */
+    public uint plugins_constructed { get; private set; default = 0; }
+
+    /**
+     * The number of requests for a shared plugin which were served from the
+     * cache, without constructing a plugin.
+     */
+    public uint constructions_saved { get; private set; default = 0; }
+
+    /**
+     * Get the cache shared by the whole process, which evicts the plugins of
+     * the accounts changed through the shared Ag.Manager.
+     *
+     * @return the default PluginCache
+     */
+    public static PluginCache get_default ()
+    {
+        if (default_cache == null)
+        {
+            default_cache = new PluginCache (DataCatalog.get_default ().manager,
+                                             DEFAULT_MAX_SIZE);
+        }
+
+        return default_cache;
+    }
+
+    /**
+     * Create a plugin cache.
+     *
+     * @param manager the account manager whose account changes evict the
+     * plugins
+     * @param max_size the maximum number of plugins to keep
+     */
+    public PluginCache (Ag.Manager manager, uint max_size)
+    {
+        Object (max_size: max_size);
+
+        manager.account_updated.connect (evict);
+        manager.account_deleted.connect (evict);
+    }
+
+    construct
+    {
+        plugins = new HashTable<uint, Ap.Plugin> (direct_hash, direct_equal);
+        plugin_order = new Queue<uint> ();
+    }
+
+    /**
+     * Get the shared plugin of an account, loading it if it is not cached.
+     * The caller must not change the state of the plugin, or connect to its
+     * finished signal.
+     *
+     * @param account the account
+     * @param cancellable a Cancellable for the load, or null
+     * @return the plugin, or null if there is no valid plugin for the
+     * provider of the account
+     */
+    public async Ap.Plugin? load_shared_async (Ag.Account account,
+                                               Cancellable? cancellable = null)
+        throws Error
+    {
+        var plugin = plugins.lookup (account.id);
+        if (plugin != null)
+        {
+            constructions_saved++;
+            plugin_order.remove (account.id);
+            plugin_order.push_head (account.id);
+            return plugin;
+        }
+
+        plugin = yield load_fresh_async (account, cancellable);
+
+        // Accounts which are not stored yet have no ID to be cached by.
+        if (plugin != null && account.id != 0)
+        {
+            if (plugins.contains (account.id))
+            {
+                // Another load for the same account finished first.
+                return plugins.lookup (account.id);
+            }
+
+            plugins.insert (account.id, plugin);
+            plugin_order.push_head (account.id);
+
+            while (plugin_order.get_length () > max_size)
+            {
+                plugins.remove (plugin_order.pop_tail ());
+            }
+        }
+
+        return plugin;
+    }
+
+    /**
+     * Load a new plugin for an account, which is not shared with anyone.
+     *
+     * @param account the account
+     * @param cancellable a Cancellable for the load, or null
+     * @return the plugin, or null if there is no valid plugin for the
+     * provider of the account
+     */
+    public async Ap.Plugin? load_fresh_async (Ag.Account account,
+                                              Cancellable? cancellable = null)
+        throws Error
+    {
+        var plugin = yield construct_plugin (account, cancellable);
+        if (plugin != null)
+        {
+            plugins_constructed++;
+        }
+
+        return plugin;
+    }
+
+    /**
+     * Construct a plugin for an account. Overridden in tests.
+     *
+     * @param account the account
+     * @param cancellable a Cancellable for the load, or null
+     * @return the plugin, or null if there is no valid plugin for the
+     * provider of the account
+     */
+    internal virtual async Ap.Plugin? construct_plugin (Ag.Account account,
+                                                        Cancellable? cancellable)
+        throws Error
+    {
+        return yield Ap.client_load_plugin_async (account, cancellable);
+    }
+
+    /**
+     * Drop the cached plugin of an account.
+     *
+     * @param account_id the ID of the account
+     */
+    public void evict (uint account_id)
+    {
+        if (plugins.remove (account_id))
+        {
+            plugin_order.remove (account_id);
+        }
+    }
+}
@@ -72,7 +72,8 @@ public class Cc.Credentials.Preferences : Gtk.Notebook
         expand = true;
         border_width = 18;
 
-        accounts_manager = new Ag.Manager ();
+        // The Ag.Manager is shared with the pages, through the DataCatalog.
+        accounts_manager = DataCatalog.get_default ().manager;
 
         /* invoke the update-accounts tool to enable any newly installed
          * services on the existing accounts.
@@ -210,6 +211,8 @@ public class Cc.Credentials.Preferences : Gtk.Notebook
      */
     private void on_account_application_options_finished (Ap.ApplicationPlugin plugin)
     {
+        plugin.finished.disconnect (on_account_application_options_finished);
+
         var plugin_err = plugin.get_error ();
         if (plugin_err != null)
         {
@@ -253,6 +256,8 @@ public class Cc.Credentials.Preferences : Gtk.Notebook
      */
     private void on_account_edit_options_finished (Ap.Plugin plugin)
     {
+        plugin.finished.disconnect (on_account_edit_options_finished);
+
         var plugin_err = plugin.get_error ();
         if (plugin_err != null)
         {
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2012 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Order in which providers are offered to the user. The order for each
+ * application is read from the provider-ranking.conf key file, and the
+ * providers which the user chooses often are boosted, based on usage counts
+ * stored in the user data directory.
+ */
+public class Cc.Credentials.ProviderRanking : Object
+{
+    private static ProviderRanking default_ranking;
+    /* Rank of each configured provider, keyed by application name. */
+    private HashTable<string, HashTable<string, int>> ranks;
+    private HashTable<string, uint> usage;
+    private string? usage_path;
+
+    /* The application whose ranking is used by default. */
+    private const string DEFAULT_APPLICATION = "all";
+    private const string RANKING_GROUP = "Ranking";
+    private const string USAGE_GROUP = "Usage";
+    /* A single use of a provider outweighs its configured rank. */
+    private const int USAGE_WEIGHT = 100;
+    /* Keep the usage boost of a provider within the range of an int. */
+    private const uint MAX_USAGE = 1000000;
+
+    /**
+     * Get the ranking shared by the whole process, read from the
+     * configuration and usage files of the user.
+     *
+     * @return the default ProviderRanking
+     */
+    public static ProviderRanking get_default ()
+    {
+        if (default_ranking == null)
+        {
+            var config_dirs = new string[] { Environment.get_user_config_dir () };
+            foreach (var config_dir in Environment.get_system_config_dirs ())
+            {
+                config_dirs += config_dir;
+            }
+            /* The default ranking is installed in $(sysconfdir)/xdg, which
+             * is only in XDG_CONFIG_DIRS when sysconfdir is /etc. */
+            config_dirs += Path.build_filename (Config.SYSCONFDIR, "xdg");
+
+            // The configuration of the user overrides the system-wide one.
+            string? config_path = null;
+            foreach (var config_dir in config_dirs)
+            {
+                var path = Path.build_filename (config_dir,
+                                                "credentials-control-center",
+                                                "provider-ranking.conf");
+                if (FileUtils.test (path, FileTest.EXISTS))
+                {
+                    config_path = path;
+                    break;
+                }
+            }
+
+            var usage_path = Path.build_filename (Environment.get_user_data_dir (),
+                                                  "credentials-control-center",
+                                                  "provider-usage");
+            default_ranking = new ProviderRanking (config_path, usage_path);
+        }
+
+        return default_ranking;
+    }
+
+    /**
+     * Create a ranking from the given files.
+     *
+     * @param config_path the path of the ranking configuration, or null for
+     * no configured ranking
+     * @param usage_path the path of the usage counts, or null to not count
+     * the usage of providers
+     */
+    public ProviderRanking (string? config_path, string? usage_path)
+    {
+        ranks = new HashTable<string, HashTable<string, int>> (str_hash,
+                                                                str_equal);
+        usage = new HashTable<string, uint> (str_hash, str_equal);
+        this.usage_path = usage_path;
+
+        if (config_path != null)
+        {
+            load_ranks (config_path);
+        }
+
+        if (usage_path != null)
+        {
+            load_usage (usage_path);
+        }
+    }
+
+    /**
+     * Read the ranks of the providers of each application.
+     *
+     * @param config_path the path of the ranking configuration
+     */
+    private void load_ranks (string config_path)
+    {
+        var config = new KeyFile ();
+
+        try
+        {
+            config.load_from_file (config_path, KeyFileFlags.NONE);
+
+            foreach (var application_name in config.get_keys (RANKING_GROUP))
+            {
+                var providers = config.get_string_list (RANKING_GROUP,
+                                                        application_name);
+                var application_ranks = new HashTable<string, int> (str_hash,
+                                                                    str_equal);
+
+                /* The first provider gets the most negative rank, and the
+                 * ranks stay above the boost of a single use. */
+                for (var i = 0; i < providers.length && i < USAGE_WEIGHT - 1; i++)
+                {
+                    if (!application_ranks.contains (providers[i]))
+                    {
+                        application_ranks.insert (providers[i],
+                                                  i - (USAGE_WEIGHT - 1));
+                    }
+                }
+
+                ranks.insert (application_name, application_ranks);
+            }
+        }
+        catch (Error error)
+        {
+            message ("Error loading provider ranking from %s: %s",
+                     config_path, error.message);
+        }
+    }
+
+    /**
+     * Read the number of times that each provider was chosen.
+     *
+     * @param usage_path the path of the usage counts
+     */
+    private void load_usage (string usage_path)
+    {
+        var usage_file = new KeyFile ();
+
+        try
+        {
+            usage_file.load_from_file (usage_path, KeyFileFlags.NONE);
+
+            foreach (var provider_name in usage_file.get_keys (USAGE_GROUP))
+            {
+                var count = usage_file.get_uint64 (USAGE_GROUP, provider_name);
+                usage.insert (provider_name, (uint) uint64.min (count, MAX_USAGE));
+            }
+        }
+        catch (KeyFileError error)
+        {
+            message ("Error loading provider usage from %s: %s",
+                     usage_path, error.message);
+        }
+        catch (FileError error)
+        {
+            // No provider was chosen yet.
+        }
+    }
+
+    /**
+     * Get the sort key of a provider for an application, for use in the
+     * ROW_SORT column of ProvidersModel. Both the ranking and the usage
+     * counts are looked up in hash tables.
+     *
+     * @param application_name the name of the application, or "all"
+     * @param provider_name the name of the provider
+     * @return the sort key, with more negative numbers being sorted first
+     */
+    public int get_sort_key (string? application_name, string provider_name)
+    {
+        var application_ranks = application_name != null ?
+            ranks.lookup (application_name) : null;
+        if (application_ranks == null)
+        {
+            application_ranks = ranks.lookup (DEFAULT_APPLICATION);
+        }
+
+        var rank = 0;
+        if (application_ranks != null && application_ranks.contains (provider_name))
+        {
+            rank = application_ranks.lookup (provider_name);
+        }
+
+        return rank - (int) usage.lookup (provider_name) * USAGE_WEIGHT;
+    }
+
+    /**
+     * Get the number of times that a provider was chosen.
+     *
+     * @param provider_name the name of the provider
+     * @return the usage count
+     */
+    public uint get_usage (string provider_name)
+    {
+        return usage.lookup (provider_name);
+    }
+
+    /**
+     * Count a choice of a provider by the user, and store the usage counts.
+     * The new counts are used the next time the providers model is built, so
+     * that the list does not change under the pointer of the user.
+     *
+     * @param provider_name the name of the chosen provider
+     */
+    public void record_usage (string provider_name)
+    {
+        if (usage_path == null)
+        {
+            return;
+        }
+
+        var count = usage.lookup (provider_name);
+        if (count < MAX_USAGE)
+        {
+            usage.insert (provider_name, count + 1);
+        }
+
+        var usage_file = new KeyFile ();
+        usage.foreach ((name, name_count) =>
+        {
+            usage_file.set_uint64 (USAGE_GROUP, name, name_count);
+        });
+
+        try
+        {
+            DirUtils.create_with_parents (Path.get_dirname (usage_path), 0755);
+            FileUtils.set_contents (usage_path, usage_file.to_data ());
+        }
+        catch (FileError error)
+        {
+            message ("Error storing provider usage: %s", error.message);
+        }
+    }
+}
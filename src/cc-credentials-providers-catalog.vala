@@ -0,0 +1,338 @@
+/*
+ * Copyright 2012 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * On-disk cache of the resolved provider and application rows shown by
+ * ProvidersModel. Building the rows requires parsing the provider, service
+ * and application XML files, and the desktop files of the applications, so
+ * the result is stored as a serialized GVariant, which is memory-mapped when
+ * it is loaded. The catalog is only used if the modification times of the
+ * directories that the rows were built from, and the locale, are unchanged.
+ * The rows are sorted when they are loaded, so that changes to the
+ * ProviderRanking do not make the catalog outdated. The applications shown
+ * by ApplicationsModel are stored alongside the rows.
+ */
+public class Cc.Credentials.ProvidersCatalog : Object
+{
+    /* Increase when the layout of the catalog changes. */
+    private const uint32 FORMAT_VERSION = 3;
+    /* Format version, locale, directory stamps, rows and applications. */
+    private const string CATALOG_TYPE = "(usa(sx)a(sssssss)a(ss))";
+    /* Modification times closer to the present than this, in microseconds,
+     * may not change when the directory is modified again. */
+    private const int64 TIMESTAMP_RESOLUTION = TimeSpan.SECOND;
+
+    private string path;
+
+    /**
+     * A resolved row of the providers model. Icons are stored as the result
+     * of Icon.to_string ().
+     */
+    public struct Entry
+    {
+        public string application_name;
+        public string application_icon;
+        public string application_description;
+        public string provider_name;
+        public string provider_icon;
+        public string provider_description;
+        public string tooltip;
+    }
+
+    /**
+     * An application which integrates with one of the services, as listed
+     * by ApplicationsModel.
+     */
+    public struct ApplicationEntry
+    {
+        public string name;
+        public string description;
+    }
+
+    /**
+     * Create a catalog stored at the given path.
+     *
+     * @param path the path of the catalog file
+     */
+    public ProvidersCatalog (string path)
+    {
+        this.path = path;
+    }
+
+    /**
+     * Get the path of the catalog in the cache directory of the user.
+     *
+     * @return the default catalog path
+     */
+    public static string get_default_path ()
+    {
+        return Path.build_filename (Environment.get_user_cache_dir (),
+                                    "credentials-control-center",
+                                    "providers-catalog");
+    }
+
+    /**
+     * Get the directories which the rows of the catalog are built from: the
+     * libaccounts provider, service and application directories, the
+     * desktop file directories and the provider plugin directory.
+     *
+     * @return the list of directory paths
+     */
+    public static string[] get_source_directories ()
+    {
+        string[] directories = {};
+
+        // The same lookup as libaccounts-glib.
+        string[,] accounts_dirs = { { "AG_PROVIDERS", "providers" },
+                                    { "AG_SERVICES", "services" },
+                                    { "AG_APPLICATIONS", "applications" } };
+        for (var i = 0; i < accounts_dirs.length[0]; i++)
+        {
+            var env_dir = Environment.get_variable (accounts_dirs[i, 0]);
+            if (env_dir != null)
+            {
+                directories += env_dir;
+                continue;
+            }
+
+            directories += Path.build_filename (Environment.get_user_data_dir (),
+                                                "accounts",
+                                                accounts_dirs[i, 1]);
+            foreach (var data_dir in Environment.get_system_data_dirs ())
+            {
+                directories += Path.build_filename (data_dir, "accounts",
+                                                    accounts_dirs[i, 1]);
+            }
+        }
+
+        directories += Path.build_filename (Environment.get_user_data_dir (),
+                                            "applications");
+        foreach (var data_dir in Environment.get_system_data_dirs ())
+        {
+            directories += Path.build_filename (data_dir, "applications");
+        }
+
+        directories += Ap.client_get_provider_plugin_dir ();
+
+        return directories;
+    }
+
+    /**
+     * Get the current modification times of the source directories. Take
+     * the stamps before reading the data files to build the rows, so that
+     * changes made in the meantime make the catalog outdated.
+     *
+     * @return an array of directory paths and modification times, in
+     * microseconds, or -1 for missing directories
+     */
+    public static Variant get_stamps ()
+    {
+        var builder = new VariantBuilder (new VariantType ("a(sx)"));
+
+        foreach (var directory in get_source_directories ())
+        {
+            int64 mtime = -1;
+
+            try
+            {
+                var info = File.new_for_path (directory).query_info (
+                    FileAttribute.TIME_MODIFIED + ","
+                    + FileAttribute.TIME_MODIFIED_USEC,
+                    FileQueryInfoFlags.NONE);
+                mtime = (int64) info.get_attribute_uint64 (FileAttribute.TIME_MODIFIED) * 1000000
+                        + info.get_attribute_uint32 (FileAttribute.TIME_MODIFIED_USEC);
+            }
+            catch (Error error)
+            {
+                // The directory does not exist (yet).
+            }
+
+            builder.add ("(sx)", directory, mtime);
+        }
+
+        return builder.end ();
+    }
+
+    /**
+     * Check whether any directory was modified so recently that a further
+     * change could leave its modification time unchanged.
+     *
+     * @param stamps the result of get_stamps ()
+     * @return true if the stamps cannot be trusted, false otherwise
+     */
+    private static bool stamps_are_racy (Variant stamps)
+    {
+        var now = get_real_time ();
+
+        foreach (var stamp in stamps)
+        {
+            int64 mtime;
+            stamp.get ("(sx)", null, out mtime);
+
+            if (mtime != -1 && mtime > now - TIMESTAMP_RESOLUTION)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Get the locale of translated messages, as the rows contain translated
+     * strings.
+     *
+     * @return the name of the locale
+     */
+    private static string get_locale ()
+    {
+        return Intl.setlocale (LocaleCategory.MESSAGES, null) ?? "";
+    }
+
+    /**
+     * Load the rows of the catalog, if it is up to date.
+     *
+     * @param applications the applications stored in the catalog
+     * @return the rows, or null if the catalog is missing or outdated
+     */
+    public Entry[]? load (out ApplicationEntry[] applications)
+    {
+        MappedFile mapped_file;
+
+        applications = {};
+
+        try
+        {
+            mapped_file = new MappedFile (path, false);
+        }
+        catch (FileError error)
+        {
+            if (!(error is FileError.NOENT))
+            {
+                message ("Error mapping providers catalog: %s", error.message);
+            }
+            return null;
+        }
+
+        var catalog = new Variant.from_bytes (new VariantType (CATALOG_TYPE),
+                                              mapped_file.get_bytes (),
+                                              false);
+
+        if (catalog.get_child_value (0).get_uint32 () != FORMAT_VERSION
+            || catalog.get_child_value (1).get_string () != get_locale ()
+            || !catalog.get_child_value (2).equal (get_stamps ()))
+        {
+            debug ("Providers catalog %s is outdated", path);
+            return null;
+        }
+
+        var rows = catalog.get_child_value (3);
+        var entries = new Entry[rows.n_children ()];
+
+        for (var i = 0; i < entries.length; i++)
+        {
+            rows.get_child (i, "(sssssss)",
+                            out entries[i].application_name,
+                            out entries[i].application_icon,
+                            out entries[i].application_description,
+                            out entries[i].provider_name,
+                            out entries[i].provider_icon,
+                            out entries[i].provider_description,
+                            out entries[i].tooltip);
+        }
+
+        var application_rows = catalog.get_child_value (4);
+        applications = new ApplicationEntry[application_rows.n_children ()];
+
+        for (var i = 0; i < applications.length; i++)
+        {
+            application_rows.get_child (i, "(ss)",
+                                        out applications[i].name,
+                                        out applications[i].description);
+        }
+
+        return entries;
+    }
+
+    /**
+     * Store the rows in the catalog, together with the modification times of
+     * the source directories that they were built from. The catalog is not
+     * stored if a directory was modified within the timestamp resolution,
+     * as a later change might then go unnoticed. The catalog is replaced
+     * atomically, so that it can be mapped by other processes in the
+     * meantime.
+     *
+     * @param entries the rows to store
+     * @param applications the applications to store
+     * @param stamps the result of get_stamps (), taken before building the
+     * rows
+     * @return true if the catalog was stored, false otherwise
+     */
+    public bool save (Entry[] entries,
+                      ApplicationEntry[] applications,
+                      Variant stamps)
+    {
+        if (stamps_are_racy (stamps))
+        {
+            debug ("Not writing providers catalog %s, as the data files were just modified",
+                   path);
+            return false;
+        }
+
+        var builder = new VariantBuilder (new VariantType ("a(sssssss)"));
+
+        foreach (var entry in entries)
+        {
+            builder.add ("(sssssss)",
+                         entry.application_name ?? "",
+                         entry.application_icon ?? "",
+                         entry.application_description ?? "",
+                         entry.provider_name ?? "",
+                         entry.provider_icon ?? "",
+                         entry.provider_description ?? "",
+                         entry.tooltip ?? "");
+        }
+
+        var application_builder = new VariantBuilder (new VariantType ("a(ss)"));
+
+        foreach (var application in applications)
+        {
+            application_builder.add ("(ss)",
+                                     application.name ?? "",
+                                     application.description ?? "");
+        }
+
+        var catalog = new Variant ("(us@a(sx)@a(sssssss)@a(ss))",
+                                   FORMAT_VERSION,
+                                   get_locale (),
+                                   stamps,
+                                   builder.end (),
+                                   application_builder.end ());
+
+        try
+        {
+            DirUtils.create_with_parents (Path.get_dirname (path), 0755);
+            FileUtils.set_data (path, catalog.get_data_as_bytes ().get_data ());
+        }
+        catch (FileError error)
+        {
+            message ("Error writing providers catalog: %s", error.message);
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -19,11 +19,119 @@
 
 /**
  * Web credentials providers Gtk.ListStore. Used as a model for the providers
- * managed by libaccounts-glib.
+ * managed by libaccounts-glib. The resolved rows are cached in a
+ * ProvidersCatalog, so that the provider and service files only need to be
+ * parsed when they change.
  */
 public class Cc.Credentials.ProvidersModel : Gtk.ListStore
 {
-    private Ag.Manager manager;
+    /* The rows of each application, keyed by application name. */
+    private HashTable<string, ApplicationRows> application_rows;
+    private uint next_row_id = 0;
+    private uint[] free_row_ids = {};
+    private ProvidersCatalog.ApplicationEntry[] applications = {};
+
+    /**
+     * The set of rows of the model which belong to one application, stored
+     * as a bitmap indexed by the ROW_ID column, together with the number of
+     * rows. The set is updated as rows are added and removed, so that a
+     * filter on an application does not need to compare names.
+     */
+    public class ApplicationRows
+    {
+        private uint32[] bits = {};
+        private int row_count = 0;
+
+        /**
+         * The number of rows which belong to the application.
+         */
+        public int count
+        {
+            get
+            {
+                return row_count;
+            }
+        }
+
+        /**
+         * Check whether a row belongs to the application.
+         *
+         * @param row_id the ROW_ID of the row
+         * @return true if the row belongs to the application, false otherwise
+         */
+        public bool contains (uint row_id)
+        {
+            var word = row_id / 32;
+
+            return word < bits.length && (bits[word] & ((uint32) 1 << (row_id % 32))) != 0;
+        }
+
+        /**
+         * Add a row to the set.
+         *
+         * @param row_id the ROW_ID of the row
+         */
+        internal void add (uint row_id)
+        {
+            var word = row_id / 32;
+            if (word >= bits.length)
+            {
+                var old_length = bits.length;
+                bits.resize ((int) word + 1);
+                for (var i = old_length; i < bits.length; i++)
+                {
+                    bits[i] = 0;
+                }
+            }
+
+            if (!contains (row_id))
+            {
+                bits[word] |= (uint32) 1 << (row_id % 32);
+                row_count++;
+            }
+        }
+
+        /**
+         * Remove a row from the set.
+         *
+         * @param row_id the ROW_ID of the row
+         */
+        internal void remove (uint row_id)
+        {
+            if (contains (row_id))
+            {
+                bits[row_id / 32] &= ~((uint32) 1 << (row_id % 32));
+                row_count--;
+            }
+        }
+    }
+
+    /**
+     * Whether the rows were loaded from an up-to-date catalog, rather than
+     * built from the libaccounts data files.
+     */
+    public bool loaded_from_catalog { get; private set; default = false; }
+
+    /**
+     * The path of the catalog used to cache the rows.
+     */
+    public string catalog_path { get; construct; }
+
+    /**
+     * The ranking used to sort the providers.
+     */
+    public ProviderRanking ranking { get; construct; }
+
+    /**
+     * The catalog of providers, services and applications to build the rows
+     * from.
+     */
+    public DataCatalog data_catalog { get; construct; }
+
+    /**
+     * Emitted after the applications returned by get_applications () changed.
+     */
+    public signal void applications_changed ();
 
     /**
      * Identifiers for columns in the providers model.
@@ -37,8 +145,10 @@ public class Cc.Credentials.ProvidersModel : Gtk.ListStore
      * @param PROVIDER_ICON the icon of the account provider
      * @param PROVIDER_DESCRIPTION the description of the provider
      * @param TOOLTIP the tooltip to show for the row
-     * @param ROW_SORT the sort priority of the row, with more negative numbers
-     * being sorted first
+     * @param ROW_SORT the sort priority of the row, from the ProviderRanking,
+     * with more negative numbers being sorted first
+     * @param ROW_ID the index of the row in the ApplicationRows bitmaps, which
+     * is reused after the row is removed
      */
     public enum ModelColumns
     {
@@ -49,7 +159,8 @@ public class Cc.Credentials.ProvidersModel : Gtk.ListStore
         PROVIDER_ICON = 4,
         PROVIDER_DESCRIPTION = 5,
         TOOLTIP = 6,
-        ROW_SORT = 7
+        ROW_SORT = 7,
+        ROW_ID = 8
     }
 
     /**
@@ -57,244 +168,456 @@ public class Cc.Credentials.ProvidersModel : Gtk.ListStore
      */
     public ProvidersModel ()
     {
-        Object ();
+        Object (catalog_path: ProvidersCatalog.get_default_path (),
+                ranking: ProviderRanking.get_default (),
+                data_catalog: DataCatalog.get_default ());
+    }
+
+    /**
+     * Create a new data model for the list of providers, caching the rows in
+     * a catalog at the given path.
+     *
+     * @param catalog_path the path of the catalog file
+     * @param ranking the ranking used to sort the providers, or null for the
+     * default ranking
+     * @param data_catalog the catalog to build the rows from, or null for the
+     * default catalog
+     */
+    public ProvidersModel.with_catalog (string catalog_path,
+                                        ProviderRanking? ranking = null,
+                                        DataCatalog? data_catalog = null)
+    {
+        Object (catalog_path: catalog_path,
+                ranking: ranking ?? ProviderRanking.get_default (),
+                data_catalog: data_catalog ?? DataCatalog.get_default ());
     }
 
     construct
     {
         Type[] types = { typeof (string), typeof (Icon), typeof (string),
                          typeof (string), typeof (Icon), typeof (string),
-                         typeof (string), typeof (int) };
+                         typeof (string), typeof (int), typeof (uint) };
         set_column_types (types);
 
-        // TODO: Use the same Ag.Manager throughout.
-        manager = new Ag.Manager ();
+        application_rows = new HashTable<string, ApplicationRows> (str_hash,
+                                                                   str_equal);
 
         populate_model ();
 
         set_sort_column_id (ModelColumns.ROW_SORT, Gtk.SortType.ASCENDING);
-        // FIXME: No notification signals for adding new providers.
+
+        data_catalog.changed.connect (on_data_catalog_changed);
     }
 
     /**
-     * Populate the model with the current list of providers and associated
-     * application, by querying for available services and then listing the
-     * applications available for each service.
+     * Populate the model with the rows from the catalog, or with the current
+     * list of providers and associated applications if the catalog is
+     * outdated, updating the catalog.
      */
     private void populate_model ()
     {
-        var services = manager.list_services ();
-        var providers = manager.list_providers ();
-
-        // Add list of providers with unfilled application fields.
-        providers.foreach (add_provider);
+        ProvidersCatalog.ApplicationEntry[] catalog_applications;
+        var catalog = new ProvidersCatalog (catalog_path);
+        var entries = catalog.load (out catalog_applications);
 
-        foreach (var service in services)
+        loaded_from_catalog = entries != null;
+        if (entries == null)
         {
-            var applications = manager.list_applications_by_service (service);
-            var provider_name = service.get_provider ();
-            var provider = manager.get_provider (provider_name);
-            if (provider == null) continue;
+            var stamps = ProvidersCatalog.get_stamps ();
+            entries = build_entries (out catalog_applications);
+            catalog.save (entries, catalog_applications, stamps);
+        }
 
-            foreach (var application in applications)
-            {
-                var desktop_info = application.get_desktop_app_info ();
-                var application_name = application.get_name ();
+        applications = catalog_applications;
+        apply_entries (entries);
+    }
 
-                Icon app_icon = null;
-                string application_description = "";
+    /**
+     * Update the model and the catalog after the libaccounts data files, the
+     * desktop files or the plugins changed.
+     */
+    private void on_data_catalog_changed ()
+    {
+        ProvidersCatalog.ApplicationEntry[] catalog_applications;
+        var stamps = ProvidersCatalog.get_stamps ();
+        var entries = build_entries (out catalog_applications);
+        new ProvidersCatalog (catalog_path).save (entries, catalog_applications,
+                                                  stamps);
 
-                if (desktop_info == null)
-                {
-                    message ("No desktop app info found for application name: %s",
-                             application_name);
-                }
-                else
-                {
-                    // Load a themed application icon.
-                    app_icon = desktop_info.get_icon ();
+        applications = catalog_applications;
+        apply_entries (entries);
 
-                    application_description = desktop_info.get_display_name ()
-                                              + "\n<small>"
-                                              + desktop_info.get_description ()
-                                              + "</small>";
-                }
+        applications_changed ();
+    }
 
+    /**
+     * Get the applications which integrate with the installed services, as
+     * stored in the catalog, so that they can be listed without parsing the
+     * data files.
+     *
+     * @return the applications
+     */
+    public ProvidersCatalog.ApplicationEntry[] get_applications ()
+    {
+        return applications;
+    }
 
-                // Load a themed provider icon.
-                Icon provider_icon = null;
+    /**
+     * Update the rows of the model to match the given rows. Rows are matched
+     * by application and provider name, and only the rows which were added,
+     * removed or changed are touched.
+     *
+     * @param entries the new rows of the model
+     */
+    internal void apply_entries (ProvidersCatalog.Entry[] entries)
+    {
+        var existing_rows = new HashTable<string, Gtk.TreeIter?> (str_hash,
+                                                                  str_equal);
+        var occurrences = new HashTable<string, int> (str_hash, str_equal);
 
-                try
-                {
-                    provider_icon = Icon.new_for_string (provider.get_icon_name ());
-                }
-                catch (Error error)
+        Gtk.TreeIter iter;
+        if (get_iter_first (out iter))
+        {
+            do
+            {
+                string application_name;
+                string provider_name;
+                this.get (iter,
+                     ModelColumns.APPLICATION_NAME, out application_name,
+                     ModelColumns.PROVIDER_NAME, out provider_name,
+                     -1);
+                existing_rows.insert (make_row_key (occurrences,
+                                                    application_name,
+                                                    provider_name),
+                                      iter);
+            } while (iter_next (ref iter));
+        }
+
+        occurrences.remove_all ();
+        foreach (var entry in entries)
+        {
+            var key = make_row_key (occurrences, entry.application_name,
+                                    entry.provider_name);
+
+            if (existing_rows.contains (key))
+            {
+                Gtk.TreeIter row_iter = existing_rows.lookup (key);
+                existing_rows.remove (key);
+
+                if (!row_matches_entry (row_iter, entry))
                 {
-                    message ("Failed to load provider icon: %s",
-                             error.message);
+                    set_entry (row_iter, entry);
                 }
-
-                // Determine the sort order.
-                int sort_order;
-
-                if (application_name == "gwibber")
-                    sort_order = determine_sort_order_gwibber (provider_name);
-                else if (application_name == "empathy")
-                    sort_order = determine_sort_order_empathy (provider_name);
-                else if (application_name == "shotwell")
-                    sort_order = determine_sort_order_shotwell (provider_name);
-                else if (application_name == "thunderbird")
-                    sort_order = determine_sort_order_thunderbird (provider_name);
-                else
-                    sort_order = determine_sort_order_dash (provider_name);
-
-                insert_with_values (null, 0,
-                                    ModelColumns.APPLICATION_NAME, application.get_name (),
-                                    ModelColumns.APPLICATION_ICON, app_icon,
-                                    ModelColumns.APPLICATION_DESCRIPTION, application_description,
-                                    ModelColumns.PROVIDER_NAME, provider.get_name (),
-                                    ModelColumns.PROVIDER_ICON, provider_icon,
-                                    ModelColumns.PROVIDER_DESCRIPTION, format_provider_description (provider),
-                                    ModelColumns.TOOLTIP, format_provider_tooltip (provider),
-                                    ModelColumns.ROW_SORT, sort_order,
-                                    -1);
+            }
+            else
+            {
+                insert_entry (entry);
             }
         }
+
+        // Remove the rows which are gone.
+        existing_rows.foreach ((key, removed_iter) =>
+        {
+            remove_row (removed_iter);
+        });
     }
 
     /**
-     * Add the supplied provider to the store of providers.
+     * Get the rows which belong to an application. The returned set is kept
+     * up to date as the model changes.
      *
-     * This method is intended to be used with the foreach method of GLib
-     * containers.
+     * @param application_name the name of the application, or "all" for the
+     * rows of providers without an application
+     * @return the rows of the application
+     */
+    public ApplicationRows get_application_rows (string application_name)
+    {
+        var rows = application_rows.lookup (application_name);
+        if (rows == null)
+        {
+            rows = new ApplicationRows ();
+            application_rows.insert (application_name, rows);
+        }
+
+        return rows;
+    }
+
+    /**
+     * Check whether a row belongs to a set of application rows, without
+     * comparing the application name of the row.
      *
-     * @param provider an Ag.Provider to add to the list of providers
+     * @param iter the row to check
+     * @param rows the rows of an application, from get_application_rows ()
+     * @return true if the row belongs to the application, false otherwise
      */
-    private void add_provider (Ag.Provider provider)
+    public bool row_in_application (Gtk.TreeIter iter, ApplicationRows rows)
     {
-        Icon provider_icon = null;
+        uint row_id;
+        this.get (iter, ModelColumns.ROW_ID, out row_id, -1);
 
-        if (!Ap.client_has_plugin (provider))
-            return;
+        return rows.contains (row_id);
+    }
 
-        try
-        {
-            provider_icon = Icon.new_for_string (provider.get_icon_name ());
-        }
-        catch (Error error)
-        {
-            message ("Failed to load provider icon: %s", error.message);
-        }
+    /**
+     * Remove a row from the model and from the rows of its application.
+     *
+     * @param iter the row to remove
+     */
+    private void remove_row (Gtk.TreeIter iter)
+    {
+        string application_name;
+        uint row_id;
+        this.get (iter,
+                  ModelColumns.APPLICATION_NAME, out application_name,
+                  ModelColumns.ROW_ID, out row_id,
+                  -1);
+
+        // Keep the row counts right for handlers of row-deleted.
+        get_application_rows (application_name ?? "").remove (row_id);
+        remove (ref iter);
+        free_row_ids += row_id;
+    }
 
-        // Determine the sort order.
-        var provider_name = provider.get_name ();
-        var sort_order = determine_sort_order_dash (provider_name);
-
-        insert_with_values (null, 0,
-                            ModelColumns.APPLICATION_NAME, "all",
-                            ModelColumns.PROVIDER_NAME, provider_name,
-                            ModelColumns.PROVIDER_ICON, provider_icon,
-                            ModelColumns.PROVIDER_DESCRIPTION, format_provider_description (provider),
-                            ModelColumns.TOOLTIP, format_provider_tooltip (provider),
-                            ModelColumns.ROW_SORT, sort_order,
-                            -1);
+    /**
+     * Get a key identifying a row by application and provider. The same
+     * provider can be listed several times for an application, if several
+     * of its services integrate with it, so the occurrences are numbered.
+     *
+     * @param occurrences the number of rows seen so far for each key
+     * @param application_name the name of the application of the row
+     * @param provider_name the name of the provider of the row
+     * @return the key of the row
+     */
+    private static string make_row_key (HashTable<string, int> occurrences,
+                                        string? application_name,
+                                        string? provider_name)
+    {
+        var key = "%s\n%s".printf (application_name ?? "", provider_name ?? "");
+        var occurrence = occurrences.lookup (key);
+        occurrences.insert (key, occurrence + 1);
+
+        return "%s\n%d".printf (key, occurrence);
     }
 
     /**
-     * Determine the sort order for service providers for an unspecified
-     * application, or the dash, given a provider name.
+     * Check whether a row already shows the details of an entry.
      *
-     * @param provider_name the provider name
-     * @return the sort order, with a more negative number coming before others
+     * @param iter the row to check
+     * @param entry the entry to compare with
+     * @return true if the row is up to date, false otherwise
      */
-    private int determine_sort_order_dash (string provider_name)
+    private bool row_matches_entry (Gtk.TreeIter iter,
+                                    ProvidersCatalog.Entry entry)
     {
-        if (provider_name == "facebook")
-            return -5;
-        else if (provider_name == "flickr")
-            return -4;
-        else if (provider_name == "google")
-            return -3;
-        else if (provider_name == "twitter")
-            return -2;
-        else
-            return 0;
+        Icon application_icon;
+        string application_description;
+        Icon provider_icon;
+        string provider_description;
+        string tooltip;
+
+        this.get (iter,
+             ModelColumns.APPLICATION_ICON, out application_icon,
+             ModelColumns.APPLICATION_DESCRIPTION, out application_description,
+             ModelColumns.PROVIDER_ICON, out provider_icon,
+             ModelColumns.PROVIDER_DESCRIPTION, out provider_description,
+             ModelColumns.TOOLTIP, out tooltip,
+             -1);
+
+        return icon_to_string (application_icon) == (entry.application_icon ?? "")
+               && (application_description ?? "") == (entry.application_description ?? "")
+               && icon_to_string (provider_icon) == (entry.provider_icon ?? "")
+               && (provider_description ?? "") == (entry.provider_description ?? "")
+               && (tooltip ?? "") == (entry.tooltip ?? "");
     }
 
     /**
-     * Determine the sort order for service providers for Gwibber, given a
-     * provider name.
+     * Insert a row with the details of an entry, at its sorted position.
      *
-     * @param provider_name the provider name
-     * @return the sort order, with a more negative number coming before others
+     * @param entry the resolved details of the row
      */
-    private int determine_sort_order_gwibber (string provider_name)
+    private void insert_entry (ProvidersCatalog.Entry entry)
     {
-        if (provider_name == "facebook")
-            return -5;
-        else if (provider_name == "google")
-            return -4;
-        else if (provider_name == "identica")
-            return -3;
-        else if (provider_name == "twitter")
-            return -2;
+        uint row_id;
+        if (free_row_ids.length > 0)
+        {
+            row_id = free_row_ids[free_row_ids.length - 1];
+            free_row_ids.resize (free_row_ids.length - 1);
+        }
         else
-            return 0;
+        {
+            row_id = next_row_id++;
+        }
+
+        /* Filters on the model check the bitmap as soon as the row is
+         * inserted. */
+        get_application_rows (entry.application_name ?? "").add (row_id);
+
+        insert_with_values (null, -1,
+                            ModelColumns.APPLICATION_NAME, entry.application_name,
+                            ModelColumns.APPLICATION_ICON, icon_from_string (entry.application_icon),
+                            ModelColumns.APPLICATION_DESCRIPTION, entry.application_description,
+                            ModelColumns.PROVIDER_NAME, entry.provider_name,
+                            ModelColumns.PROVIDER_ICON, icon_from_string (entry.provider_icon),
+                            ModelColumns.PROVIDER_DESCRIPTION, entry.provider_description,
+                            ModelColumns.TOOLTIP, entry.tooltip,
+                            ModelColumns.ROW_SORT, ranking.get_sort_key (entry.application_name,
+                                                                         entry.provider_name),
+                            ModelColumns.ROW_ID, row_id,
+                            -1);
     }
 
     /**
-     * Determine the sort order for service providers for Empathy, given a
-     * provider name.
+     * Fill in a row with the details of an entry.
      *
-     * @param provider_name the provider name
-     * @return the sort order, with a more negative number coming before others
+     * @param iter the row to fill in
+     * @param entry the resolved details of the row
      */
-    private int determine_sort_order_empathy (string provider_name)
+    private void set_entry (Gtk.TreeIter iter, ProvidersCatalog.Entry entry)
     {
-        if (provider_name == "salut")
-            return -5;
-        else if (provider_name == "facebook")
-            return -4;
-        else if (provider_name == "google")
-            return -3;
-        else
-            return 0;
+        this.set (iter,
+              ModelColumns.APPLICATION_NAME, entry.application_name,
+              ModelColumns.APPLICATION_ICON, icon_from_string (entry.application_icon),
+              ModelColumns.APPLICATION_DESCRIPTION, entry.application_description,
+              ModelColumns.PROVIDER_NAME, entry.provider_name,
+              ModelColumns.PROVIDER_ICON, icon_from_string (entry.provider_icon),
+              ModelColumns.PROVIDER_DESCRIPTION, entry.provider_description,
+              ModelColumns.TOOLTIP, entry.tooltip,
+              ModelColumns.ROW_SORT, ranking.get_sort_key (entry.application_name,
+                                                           entry.provider_name),
+              -1);
     }
 
     /**
-     * Determine the sort order for service providers for Shotwell, given a
-     * provider name.
+     * Serialize an icon in the same way as in the catalog.
      *
-     * @param provider_name the provider name
-     * @return the sort order, with a more negative number coming before others
+     * @param icon the icon, or null
+     * @return the serialized icon, or an empty string if there is no icon
      */
-    private int determine_sort_order_shotwell (string provider_name)
+    private static string icon_to_string (Icon? icon)
     {
-        if (provider_name == "facebook")
-            return -5;
-        else if (provider_name == "flickr")
-            return -4;
-        else if (provider_name == "google")
-            return -3;
-        else
-            return 0;
+        return icon != null ? icon.to_string () : "";
     }
 
     /**
-     * Determine the sort order for service providers for Thunderbird, given a
-     * provider name.
+     * Build the rows of the model from the current list of providers and
+     * associated applications, by querying for available services and then
+     * listing the applications available for each service.
      *
-     * @param provider_name the provider name
-     * @return the sort order, with a more negative number coming before others
+     * @param applications the applications available for the services
+     * @return the rows for the model
      */
-    private int determine_sort_order_thunderbird (string provider_name)
+    private ProvidersCatalog.Entry[] build_entries (out ProvidersCatalog.ApplicationEntry[] applications)
     {
-        if (provider_name == "google")
-            return -5;
-        else if (provider_name == "yahoo")
-            return -4;
-        else
-            return 0;
+        ProvidersCatalog.Entry[] entries = {};
+        var application_hash = new HashTable<string, string> (str_hash,
+                                                              str_equal);
+
+        var services = data_catalog.list_services ();
+        var providers = data_catalog.list_providers ();
+
+        // Add list of providers with unfilled application fields.
+        foreach (var provider in providers)
+        {
+            if (!Ap.client_has_plugin (provider))
+                continue;
+
+            var entry = ProvidersCatalog.Entry ();
+            entry.application_name = "all";
+            entry.provider_name = provider.get_name ();
+            entry.provider_icon = provider.get_icon_name ();
+            entry.provider_description = format_provider_description (provider);
+            entry.tooltip = format_provider_tooltip (provider);
+            entries += entry;
+        }
+
+        foreach (var service in services)
+        {
+            var service_applications = data_catalog.list_applications_by_service (service);
+
+            // Listed even without a provider, as in ApplicationsModel.
+            foreach (var application in service_applications)
+            {
+                application_hash.insert (dgettext (application.get_i18n_domain (),
+                                                   application.get_name ()),
+                                         dgettext (application.get_i18n_domain (),
+                                                   application.get_description ()));
+            }
+
+            var provider_name = service.get_provider ();
+            var provider = data_catalog.get_provider (provider_name);
+            if (provider == null) continue;
+
+            foreach (var application in service_applications)
+            {
+                var desktop_info = data_catalog.get_desktop_app_info (application);
+                var application_name = application.get_name ();
+
+                var entry = ProvidersCatalog.Entry ();
+                entry.application_name = application_name;
+
+                if (desktop_info == null)
+                {
+                    message ("No desktop app info found for application name: %s",
+                             application_name);
+                }
+                else
+                {
+                    // Store the themed application icon.
+                    var app_icon = desktop_info.get_icon ();
+                    if (app_icon != null)
+                    {
+                        entry.application_icon = app_icon.to_string ();
+                    }
+
+                    entry.application_description = desktop_info.get_display_name ()
+                                                    + "\n<small>"
+                                                    + desktop_info.get_description ()
+                                                    + "</small>";
+                }
+
+                entry.provider_name = provider.get_name ();
+                entry.provider_icon = provider.get_icon_name ();
+                entry.provider_description = format_provider_description (provider);
+                entry.tooltip = format_provider_tooltip (provider);
+                entries += entry;
+            }
+        }
+
+        ProvidersCatalog.ApplicationEntry[] application_entries = {};
+        foreach (var name in application_hash.get_keys ())
+        {
+            var application_entry = ProvidersCatalog.ApplicationEntry ();
+            application_entry.name = name;
+            application_entry.description = application_hash.lookup (name);
+            application_entries += application_entry;
+        }
+        applications = application_entries;
+
+        return entries;
+    }
+
+    /**
+     * Load a themed icon from its serialized form.
+     *
+     * @param icon_string the result of Icon.to_string (), or an empty string
+     * @return the icon, or null if there is no icon
+     */
+    private static Icon? icon_from_string (string? icon_string)
+    {
+        if (icon_string == null || icon_string == "")
+        {
+            return null;
+        }
+
+        try
+        {
+            return Icon.new_for_string (icon_string);
+        }
+        catch (Error error)
+        {
+            message ("Failed to load icon: %s", error.message);
+            return null;
+        }
     }
 
     /**
@@ -45,11 +45,12 @@ public class Cc.Credentials.ProvidersPage : Gtk.Grid
         LABEL = 1
     }
 
-    private Ag.Manager manager;
+    private DataCatalog data_catalog;
     private Gtk.ComboBox applications_combo;
     private Gtk.Notebook providers_notebook;
+    private ProvidersModel providers_model;
     private Gtk.TreeModelFilter filter_model;
-    private string current_application;
+    private ProvidersModel.ApplicationRows current_rows;
 
     public string application_id { get; construct; }
 
@@ -68,28 +69,26 @@ public class Cc.Credentials.ProvidersPage : Gtk.Grid
         orientation = Gtk.Orientation.VERTICAL;
         expand = true;
 
-        // TODO: Use common Ag.Manager.
-        manager = new Ag.Manager ();
+        data_catalog = DataCatalog.get_default ();
+        // The applications combo lists the applications from the catalog.
+        providers_model = new ProvidersModel.with_catalog (ProvidersCatalog.get_default_path (),
+                                                           null,
+                                                           data_catalog);
 
         this.add (create_providers_selector ());
         this.add (create_providers_notebook ());
 
-        /* This defaults to -1, no selection, so force it to have the first
-         * item selected.
-         */
-        applications_combo.active = 0;
-
-        // Trigger a refilter if an application was passed in.
+        // Filter on the application that was passed in, if any.
+        var application_found = false;
         if (application_id != null)
         {
-            current_application = application_id;
-
             Gtk.TreeIter iter;
             var applications_model = applications_combo.model as ApplicationsModel;
             if (applications_model.find_iter_for_application (application_id,
                                                               out iter))
             {
                 applications_combo.set_active_iter (iter);
+                application_found = true;
             }
             else
             {
@@ -98,6 +97,14 @@ public class Cc.Credentials.ProvidersPage : Gtk.Grid
             }
         }
 
+        /* This defaults to -1, no selection, so force it to have the first
+         * item selected.
+         */
+        if (!application_found)
+        {
+            applications_combo.active = 0;
+        }
+
         set_size_request (-1, 400);
 
         show ();
@@ -111,7 +118,7 @@ public class Cc.Credentials.ProvidersPage : Gtk.Grid
     private Gtk.Widget create_providers_selector ()
     {
         var label = new Gtk.Label (_("Show accounts that integrate with:"));
-        var applications_model = new ApplicationsModel ();
+        var applications_model = new ApplicationsModel.with_providers_model (providers_model);
         applications_combo = new Gtk.ComboBox.with_model (applications_model);
         applications_combo.hexpand = true;
         var text_renderer = new Gtk.CellRendererText ();
@@ -161,9 +168,11 @@ public class Cc.Credentials.ProvidersPage : Gtk.Grid
      */
     private Gtk.Widget create_providers_tree ()
     {
-        var providers_model = new ProvidersModel ();
+        current_rows = providers_model.get_application_rows ("all");
         filter_model = new Gtk.TreeModelFilter (providers_model, null);
         filter_model.set_visible_func (filter_model_visible);
+        filter_model.row_inserted.connect (on_filter_model_rows_changed);
+        filter_model.row_deleted.connect (on_filter_model_rows_changed);
         var providers_tree = new Gtk.TreeView.with_model (filter_model);
         providers_tree.headers_visible = false;
         providers_tree.hover_selection = true;
@@ -209,12 +218,7 @@ public class Cc.Credentials.ProvidersPage : Gtk.Grid
      */
     private bool filter_model_visible (Gtk.TreeModel model, Gtk.TreeIter iter)
     {
-        string application_name;
-        model.get (iter,
-                   ApplicationsModel.ModelColumns.APPLICATION_NAME, out application_name,
-                   -1);
-
-        return application_name == current_application;
+        return providers_model.row_in_application (iter, current_rows);
     }
 
     /**
@@ -235,15 +239,28 @@ public class Cc.Credentials.ProvidersPage : Gtk.Grid
                        ApplicationsModel.ModelColumns.APPLICATION_NAME, out application_name,
                        -1);
 
-            current_application = application_name;
-            filter_model.refilter ();
+            current_rows = providers_model.get_application_rows (application_name);
 
-            // Update the widget shown in the providers notebook.
-            var n_items = filter_model.iter_n_children (null);
-            update_notebook_widget (n_items);
+            // The number of rows is known without filtering.
+            update_notebook_widget (current_rows.count);
+            filter_model.refilter ();
+        }
+        else if (applications_combo.model.iter_n_children (null) > 0)
+        {
+            // The selected application was uninstalled.
+            applications_combo.active = 0;
         }
     }
 
+    /**
+     * Handle providers being installed or removed while the page is shown,
+     * by updating the widget shown in the providers notebook.
+     */
+    private void on_filter_model_rows_changed ()
+    {
+        update_notebook_widget (current_rows.count);
+    }
+
     /**
      * Use the current selection (either with the pointer or keyboard
      * navigation) to select a provider for which to create a new account.
@@ -270,6 +287,9 @@ public class Cc.Credentials.ProvidersPage : Gtk.Grid
              */
             selection.unselect_all ();
 
+            // Offer the commonly-chosen providers first in the future.
+            ProviderRanking.get_default ().record_usage (provider_name);
+
             // Emit signal for the main panel to switch notebook page.
             new_account_request (provider_name);
         }
@@ -0,0 +1,324 @@
+/*
+ * Copyright 2012 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Process-wide client of the webcredentials indicator. The D-Bus proxy is
+ * created asynchronously, so that the panel never waits for the indicator
+ * when starting up. The Failures property is cached, and the calls made
+ * before the proxy is ready are queued, and sent in order once it is.
+ */
+public class Cc.WebcredentialsIndicatorClient : Object
+{
+    private static WebcredentialsIndicatorClient default_client;
+    private WebcredentialsIndicator indicator;
+    private uint[] cached_failures = {};
+    private Queue<PendingCall> pending_calls;
+    private bool connection_failed = false;
+
+    /**
+     * The methods of the indicator which can be queued.
+     */
+    private enum CallType
+    {
+        REPORT_FAILURE,
+        REMOVE_FAILURES,
+        CLEAR_ERROR_STATUS
+    }
+
+    /**
+     * A call made before the indicator proxy was ready.
+     */
+    private class PendingCall
+    {
+        public CallType call_type;
+        public uint account_id;
+        public HashTable<string, Variant> notification;
+        public uint[] account_ids;
+    }
+
+    /**
+     * The IDs of the accounts which currently have login failures, as last
+     * reported by the indicator.
+     */
+    public uint[] failures
+    {
+        owned get
+        {
+            return cached_failures;
+        }
+    }
+
+    /**
+     * Whether the indicator proxy is ready.
+     */
+    public bool connected
+    {
+        get
+        {
+            return indicator != null;
+        }
+    }
+
+    /**
+     * The number of calls waiting for the indicator proxy.
+     */
+    public uint pending_call_count
+    {
+        get
+        {
+            return pending_calls.get_length ();
+        }
+    }
+
+    /**
+     * Emitted when the list of failing accounts changes.
+     */
+    public signal void failures_changed ();
+
+    /**
+     * Get the client shared by the whole process. The connection to the
+     * indicator is started the first time this is called.
+     *
+     * @return the default WebcredentialsIndicatorClient
+     */
+    public static WebcredentialsIndicatorClient get_default ()
+    {
+        if (default_client == null)
+        {
+            default_client = new WebcredentialsIndicatorClient ();
+            default_client.connect_indicator.begin ();
+        }
+
+        return default_client;
+    }
+
+    /**
+     * Replace the client shared by the whole process, for instance with one
+     * connected to a fake indicator.
+     *
+     * @param client the client to return from get_default(), or null to
+     * create one on the next call
+     * @return the previous client, or null if there was none, so that it can
+     * be restored
+     */
+    internal static WebcredentialsIndicatorClient? set_default (WebcredentialsIndicatorClient? client)
+    {
+        var previous_client = default_client;
+        default_client = client;
+
+        return previous_client;
+    }
+
+    /**
+     * Create a client which is not connected to the indicator yet. Use
+     * get_default() rather than this, except to supply the indicator with
+     * set_indicator().
+     */
+    internal WebcredentialsIndicatorClient ()
+    {
+        pending_calls = new Queue<PendingCall> ();
+    }
+
+    /**
+     * Create the D-Bus proxy for the indicator asynchronously.
+     */
+    private async void connect_indicator ()
+    {
+        try
+        {
+            WebcredentialsIndicator proxy =
+                yield Bus.get_proxy (BusType.SESSION,
+                                     "com.canonical.indicators.webcredentials",
+                                     "/com/canonical/indicators/webcredentials");
+            set_indicator (proxy);
+        }
+        catch (IOError err)
+        {
+            warning ("Error initializing indicator proxy: %s\nAccount attention monitoring will be disabled", err.message);
+            connection_failed = true;
+
+            if (!pending_calls.is_empty ())
+            {
+                message ("Dropping %u calls to the webcredentials indicator",
+                         pending_calls.get_length ());
+                pending_calls.clear ();
+            }
+        }
+    }
+
+    /**
+     * Start using the indicator, reading its current list of failures and
+     * sending the queued calls to it.
+     *
+     * @param indicator the ready indicator proxy
+     */
+    internal void set_indicator (WebcredentialsIndicator indicator)
+    {
+        this.indicator = indicator;
+
+        var indicator_proxy = indicator as DBusProxy;
+        if (indicator_proxy != null)
+        {
+            indicator_proxy.g_properties_changed.connect (on_proxy_properties_changed);
+        }
+        else
+        {
+            indicator.notify["failures"].connect (on_indicator_notify_failures);
+        }
+
+        on_indicator_notify_failures ();
+        notify_property ("connected");
+
+        while (!pending_calls.is_empty ())
+        {
+            dispatch.begin (pending_calls.pop_head ());
+        }
+    }
+
+    /**
+     * Handle D-Bus property changes on the indicator proxy.
+     *
+     * @param changed_properties dictionary of changed property names and
+     * values
+     * @param invalidated_properties array of names of invalidated properties
+     */
+    private void on_proxy_properties_changed (Variant changed_properties,
+                                              string invalidated_properties[])
+    {
+        var iter = changed_properties.iterator ();
+
+        Variant change;
+        while ((change = iter.next_value ()) != null)
+        {
+            string property_name;
+            change.get ("{sv}", out property_name, null);
+
+            if (property_name == "Failures")
+            {
+                on_indicator_notify_failures ();
+            }
+        }
+    }
+
+    /**
+     * Update the cached list of failures from the indicator.
+     */
+    private void on_indicator_notify_failures ()
+    {
+        var current_failures = indicator.failures;
+        if (current_failures == null)
+        {
+            current_failures = {};
+        }
+
+        if (current_failures.length == 0 && cached_failures.length == 0)
+        {
+            return;
+        }
+
+        cached_failures = current_failures;
+        failures_changed ();
+    }
+
+    /**
+     * Report a login failure of an account to the indicator.
+     *
+     * @param account_id the ID of the failing account
+     * @param notification the details of the notification to show
+     */
+    public void report_failure (uint account_id,
+                                HashTable<string, Variant> notification)
+    {
+        var call = new PendingCall ();
+        call.call_type = CallType.REPORT_FAILURE;
+        call.account_id = account_id;
+        call.notification = notification;
+        send (call);
+    }
+
+    /**
+     * Tell the indicator that the login failures of some accounts were
+     * resolved.
+     *
+     * @param account_ids the IDs of the accounts which are no longer failing
+     */
+    public void remove_failures (uint[] account_ids)
+    {
+        var call = new PendingCall ();
+        call.call_type = CallType.REMOVE_FAILURES;
+        call.account_ids = account_ids;
+        send (call);
+    }
+
+    /**
+     * Clear the error status of the indicator.
+     */
+    public void clear_error_status ()
+    {
+        var call = new PendingCall ();
+        call.call_type = CallType.CLEAR_ERROR_STATUS;
+        send (call);
+    }
+
+    /**
+     * Send a call to the indicator, or queue it until the proxy is ready.
+     *
+     * @param call the call to send
+     */
+    private void send (PendingCall call)
+    {
+        if (indicator != null)
+        {
+            dispatch.begin (call);
+        }
+        else if (!connection_failed)
+        {
+            pending_calls.push_tail (call);
+        }
+    }
+
+    /**
+     * Make a call on the indicator proxy.
+     *
+     * @param call the call to make
+     */
+    private async void dispatch (PendingCall call)
+    {
+        try
+        {
+            switch (call.call_type)
+            {
+                case CallType.REPORT_FAILURE:
+                    yield indicator.report_failure (call.account_id,
+                                                    call.notification);
+                    break;
+                case CallType.REMOVE_FAILURES:
+                    yield indicator.remove_failures (call.account_ids);
+                    break;
+                case CallType.CLEAR_ERROR_STATUS:
+                    yield indicator.clear_error_status ();
+                    break;
+                default:
+                    assert_not_reached ();
+            }
+        }
+        catch (IOError err)
+        {
+            warning ("Error calling the webcredentials indicator: %s",
+                     err.message);
+        }
+    }
+}
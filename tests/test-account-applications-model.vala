@@ -23,6 +23,8 @@ int main (string[] args)
 
     Test.add_func ("/credentials/accountapplicationsmodel/create", accountapplicationsmodel_create);
     Test.add_func ("/credentials/accountapplicationsmodel/add_account", accountapplicationsmodel_add_account);
+    Test.add_func ("/credentials/accountapplicationsmodel/cache", accountapplicationsmodel_cache);
+    Test.add_func ("/credentials/accountapplicationsmodel/progressive", accountapplicationsmodel_progressive);
 
     Test.run ();
 
@@ -52,3 +54,76 @@ void accountapplicationsmodel_add_account ()
 
     accountapplications_model.account = account;
 }
+
+void accountapplicationsmodel_cache ()
+{
+    var catalog = Cc.Credentials.DataCatalog.get_default ();
+    var accountapplications_model = new Cc.Credentials.AccountApplicationsModel (false, catalog);
+    accountapplications_model.cache_size = 2;
+
+    var first_account = store_test_account (catalog.manager);
+    var second_account = store_test_account (catalog.manager);
+    var third_account = store_test_account (catalog.manager);
+
+    accountapplications_model.account = first_account;
+    var first_rows = accountapplications_model.application_rows.length ();
+    accountapplications_model.account = second_account;
+    assert (accountapplications_model.rows_computed == 2);
+
+    // Switching back and forth is served from the cache.
+    for (var i = 0; i < 10; i++)
+    {
+        accountapplications_model.account = first_account;
+        accountapplications_model.account = second_account;
+    }
+    assert (accountapplications_model.rows_computed == 2);
+    accountapplications_model.account = first_account;
+    assert (accountapplications_model.application_rows.length () == first_rows);
+
+    // The least recently used account is evicted.
+    accountapplications_model.account = third_account;
+    assert (accountapplications_model.rows_computed == 3);
+    accountapplications_model.account = first_account;
+    assert (accountapplications_model.rows_computed == 3);
+    accountapplications_model.account = second_account;
+    assert (accountapplications_model.rows_computed == 4);
+}
+
+void accountapplicationsmodel_progressive ()
+{
+    var catalog = Cc.Credentials.DataCatalog.get_default ();
+    var account = store_test_account (catalog.manager);
+
+    var synchronous_model = new Cc.Credentials.AccountApplicationsModel (false, catalog);
+    synchronous_model.account = account;
+    assert (synchronous_model.populated);
+
+    var progressive_model = new Cc.Credentials.AccountApplicationsModel (true, catalog);
+    var main_loop = new MainLoop ();
+    var next_position = 0;
+    progressive_model.row_added.connect ((position) =>
+    {
+        // Rows are only ever appended.
+        assert (position == next_position);
+        next_position++;
+    });
+    progressive_model.population_finished.connect (() => { main_loop.quit (); });
+
+    progressive_model.account = account;
+    if (!progressive_model.populated)
+    {
+        main_loop.run ();
+    }
+    assert (progressive_model.populated);
+
+    // The rows are the same, in the same order, as when resolved in place.
+    unowned List<Cc.Credentials.AccountApplicationRow?> expected = synchronous_model.application_rows;
+    unowned List<Cc.Credentials.AccountApplicationRow?> rows = progressive_model.application_rows;
+    assert (rows.length () == expected.length ());
+    for (; rows != null; rows = rows.next, expected = expected.next)
+    {
+        assert (rows.data.name == expected.data.name);
+        assert (rows.data.service_name == expected.data.service_name);
+    }
+    assert (next_position == progressive_model.application_rows.length ());
+}
@@ -25,6 +25,7 @@ int main (string[] args)
     Test.add_func ("/credentials/accountdetailspage/create", accountdetailspage_create);
     Test.add_func ("/credentials/accountdetailspage/set_account", accountdetailspage_set_get_account);
     */
+    Test.add_func ("/credentials/accountdetailspage/recycle_rows", accountdetailspage_recycle_rows);
 
     Test.run ();
 
@@ -70,6 +71,66 @@ void accountdetailspage_set_get_account ()
     assert (page.account == account);
 }
 
+List<Cc.Credentials.AccountApplicationRow?> make_application_rows (int n_rows)
+{
+    var rows = new List<Cc.Credentials.AccountApplicationRow?> ();
+
+    for (var i = 0; i < n_rows; i++)
+    {
+        var row = Cc.Credentials.AccountApplicationRow ()
+        {
+            name = "Application%d".printf (i),
+            icon = new ThemedIcon ("application-x-executable"),
+            description = "Application %d".printf (i),
+            has_plugin = false,
+            plugin = null,
+            plugin_widget = null,
+            service_name = "MyService"
+        };
+        rows.append (row);
+    }
+
+    return rows;
+}
+
+void accountdetailspage_recycle_rows ()
+{
+    /* prevent warnings from making the test fail */
+    Test.log_set_fatal_handler (log_is_fatal);
+
+    // Queue the calls to the webcredentials indicator rather than connecting.
+    var previous_client =
+        Cc.WebcredentialsIndicatorClient.set_default (new Cc.WebcredentialsIndicatorClient ());
+
+    var accounts_model = new Cc.Credentials.AccountsModel ();
+    var page = new Cc.Credentials.AccountDetailsPage (accounts_model);
+    var account = store_test_account (accounts_model.manager);
+
+    page.account = account;
+
+    page.bind_applications_grid (make_application_rows (3));
+    var widgets_created = page.row_widgets_created;
+    assert (widgets_created > 0);
+
+    // Rebinding the same number of rows creates no widgets.
+    for (var i = 0; i < 10; i++)
+    {
+        page.bind_applications_grid (make_application_rows (3));
+    }
+    assert (page.row_widgets_created == widgets_created);
+
+    // Fewer rows hide the surplus rows, which are reused later.
+    page.bind_applications_grid (make_application_rows (1));
+    page.bind_applications_grid (make_application_rows (3));
+    assert (page.row_widgets_created == widgets_created);
+
+    // Only the additional rows are created.
+    page.bind_applications_grid (make_application_rows (4));
+    assert (page.row_widgets_created == widgets_created + widgets_created / 3);
+
+    Cc.WebcredentialsIndicatorClient.set_default (previous_client);
+}
+
 bool log_is_fatal (string? log_domain, LogLevelFlags log_levels, string message)
 {
     return (log_levels & (LogLevelFlags.LEVEL_CRITICAL |
@@ -69,9 +69,26 @@ int main (string[] args)
 
     Test.add_func ("/libaccount-plugin/client/load_plugin/null",
                    client_load_plugin_null);
+    Test.add_func ("/libaccount-plugin/client/load_plugin_async/null",
+                   client_load_plugin_async_null);
+    Test.add_func ("/libaccount-plugin/client/load_plugin_async/no_provider",
+                   client_load_plugin_async_no_provider);
     Test.add_func ("/libaccount-plugin/client/load_application_plugin/null",
                    client_load_application_plugin_null);
+    Test.add_func ("/libaccount-plugin/client/load_application_plugin/missing",
+                   client_load_application_plugin_missing);
+    Test.add_func ("/libaccount-plugin/client/plugin_types",
+                   client_plugin_types);
+    Test.add_func ("/libaccount-plugin/client/has_plugin/manifest",
+                   client_has_plugin_manifest);
+    if (Test.perf ())
+    {
+        Test.add_func ("/libaccount-plugin/client/load_plugin/perf",
+                       client_load_plugin_perf);
+    }
     Test.add_func ("/libaccount-plugin/plugin/create", accountplugin_create);
+    Test.add_func ("/libaccount-plugin/plugin/has-widget",
+                   accountplugin_has_widget);
     Test.add_func ("/libaccount-plugin/plugin/create-headless",
                    accountplugin_create_headless);
     Test.add_func ("/libaccount-plugin/application-plugin/create",
@@ -95,6 +112,181 @@ void client_load_plugin_null ()
     assert (plugin == null);
 }
 
+void client_load_plugin_async_null ()
+{
+    Test.log_set_fatal_handler (log_is_fatal);
+
+    var manager = new Ag.Manager ();
+    var account = manager.create_account ("MyProvider");
+    var main_loop = new GLib.MainLoop (null, false);
+
+    Ap.client_load_plugin_async.begin (account, null, (obj, res) => {
+        try
+        {
+            var plugin = Ap.client_load_plugin_async.end (res);
+            assert (plugin == null);
+        }
+        catch (Error error)
+        {
+            assert_not_reached ();
+        }
+        main_loop.quit ();
+    });
+
+    main_loop.run ();
+}
+
+void client_load_plugin_async_no_provider ()
+{
+    Test.log_set_fatal_handler (log_is_fatal);
+
+    var manager = new Ag.Manager ();
+    var account = manager.create_account ("NoSuchProvider");
+    var main_loop = new GLib.MainLoop (null, false);
+    var finished = false;
+
+    /* The callback must be invoked even if the plugin cannot be looked up. */
+    Test.expect_message ("account-plugin", LogLevelFlags.LEVEL_CRITICAL,
+                         "*provider of the account not found*");
+    Ap.client_load_plugin_async.begin (account, null, (obj, res) => {
+        try
+        {
+            Ap.client_load_plugin_async.end (res);
+            assert_not_reached ();
+        }
+        catch (Error error)
+        {
+            assert (error is IOError.INVALID_ARGUMENT);
+        }
+        finished = true;
+        main_loop.quit ();
+    });
+    Test.assert_expected_messages ();
+
+    if (!finished)
+    {
+        main_loop.run ();
+    }
+    assert (finished);
+}
+
+void client_plugin_types ()
+{
+    Test.log_set_fatal_handler (log_is_fatal);
+
+    var manager = new Ag.Manager ();
+    var account = manager.create_account ("MyProvider");
+
+    Ap.client_invalidate_plugin_types (null);
+
+    Type object_type;
+    assert (!Ap.client_lookup_plugin_type ("MyProvider", out object_type));
+
+    /* The failed lookup must be recorded in the registry */
+    var plugin = Ap.client_load_plugin (account);
+    assert (plugin == null);
+    assert (Ap.client_lookup_plugin_type ("MyProvider", out object_type));
+    assert (object_type == Type.INVALID);
+
+    plugin = Ap.client_load_plugin (account);
+    assert (plugin == null);
+
+    Ap.client_invalidate_plugin_types ("MyProvider");
+    assert (!Ap.client_lookup_plugin_type ("MyProvider", out object_type));
+}
+
+void client_has_plugin_manifest ()
+{
+    Test.log_set_fatal_handler (log_is_fatal);
+
+    var manager = new Ag.Manager ();
+    var account = manager.create_account ("MyProvider");
+    var provider = manager.get_provider (account.get_provider_name ());
+
+    /* The manifest lists a plugin which is not actually installed: this
+     * checks that the answer comes from the manifest. */
+    string tmp_dir = null;
+    try
+    {
+        tmp_dir = DirUtils.make_tmp ("test-account-plugin-XXXXXX");
+    }
+    catch (FileError error)
+    {
+        assert_not_reached ();
+    }
+
+    var plugin_dir = Path.build_filename (tmp_dir, "providers");
+    var manifest_path = plugin_dir + ".manifest";
+    DirUtils.create (plugin_dir, 0700);
+    try
+    {
+        FileUtils.set_contents (manifest_path,
+                                "libaccount-plugin manifest 1\nMyProvider\n");
+    }
+    catch (FileError error)
+    {
+        assert_not_reached ();
+    }
+
+    /* A manifest written within the timestamp resolution of the directory
+     * is not trusted, so make the directory older. */
+    try
+    {
+        var modified = (uint64) (get_real_time () / TimeSpan.SECOND) - 10;
+        File.new_for_path (plugin_dir).set_attribute_uint64 (FileAttribute.TIME_MODIFIED,
+                                                             modified,
+                                                             FileQueryInfoFlags.NONE);
+    }
+    catch (Error error)
+    {
+        assert_not_reached ();
+    }
+
+    Environment.set_variable ("AP_PROVIDER_PLUGIN_DIR", plugin_dir, true);
+    assert (Ap.client_has_plugin (provider));
+
+    Environment.unset_variable ("AP_PROVIDER_PLUGIN_DIR");
+    assert (!Ap.client_has_plugin (provider));
+
+    FileUtils.unlink (manifest_path);
+    DirUtils.remove (plugin_dir);
+    DirUtils.remove (tmp_dir);
+}
+
+void client_load_plugin_perf ()
+{
+    Test.log_set_fatal_handler (log_is_fatal);
+
+    var manager = new Ag.Manager ();
+    var account = manager.create_account ("MyProvider");
+    var timer = new Timer ();
+    const int n_loads = 200;
+
+    /* Cold: the registry is emptied before each load, so that the module is
+     * looked up every time. */
+    double cold_elapsed = 0.0;
+    for (var i = 0; i < n_loads; i++)
+    {
+        Ap.client_invalidate_plugin_types (null);
+        timer.start ();
+        Ap.client_load_plugin (account);
+        cold_elapsed += timer.elapsed ();
+    }
+
+    /* Warm: the plugin type is served from the registry. */
+    timer.start ();
+    for (var i = 0; i < n_loads; i++)
+    {
+        Ap.client_load_plugin (account);
+    }
+    var warm_elapsed = timer.elapsed ();
+
+    Test.minimized_result (cold_elapsed / n_loads,
+                           "cold plugin load: %g s", cold_elapsed / n_loads);
+    Test.minimized_result (warm_elapsed / n_loads,
+                           "warm plugin load: %g s", warm_elapsed / n_loads);
+}
+
 void client_load_application_plugin_null ()
 {
     Test.log_set_fatal_handler (log_is_fatal);
@@ -107,6 +299,37 @@ void client_load_application_plugin_null ()
     assert (plugin == null);
 }
 
+void client_load_application_plugin_missing ()
+{
+    Test.log_set_fatal_handler (log_is_fatal);
+
+    var manager = new Ag.Manager ();
+    var account = manager.create_account ("MyProvider");
+    var application = manager.get_application ("Mailer");
+    uint hits, misses, first_hits, first_misses;
+
+    var plugin = Ap.client_load_application_plugin (application, account);
+    assert (plugin == null);
+    Ap.client_get_missing_application_plugin_stats (out first_hits,
+                                                    out first_misses);
+
+    /* Further lookups are answered from the cache */
+    for (var i = 0; i < 3; i++)
+    {
+        plugin = Ap.client_load_application_plugin (application, account);
+        assert (plugin == null);
+    }
+    Ap.client_get_missing_application_plugin_stats (out hits, out misses);
+    assert (hits == first_hits + 3);
+    assert (misses == first_misses);
+
+    // Checking for a plugin uses the same cache, without creating plugins.
+    assert (!Ap.client_has_application_plugin (application));
+    Ap.client_get_missing_application_plugin_stats (out hits, out misses);
+    assert (hits == first_hits + 4);
+    assert (misses == first_misses);
+}
+
 void accountplugin_create ()
 {
     var manager = new Ag.Manager ();
@@ -126,6 +349,25 @@ void accountplugin_create ()
     assert (plugin.build_widget () == plugin.widget_to_build);
 }
 
+void accountplugin_has_widget ()
+{
+    Test.log_set_fatal_handler (log_is_fatal);
+
+    var manager = new Ag.Manager ();
+    var account = manager.create_account ("MyProvider");
+
+    /* The base implementation falls back to building the widget */
+    var plugin = new TestPlugin (account);
+    plugin.widget_to_build = null;
+    assert (!plugin.has_widget ());
+    plugin.widget_to_build = new Gtk.Label ("Hello world!");
+    assert (plugin.has_widget ());
+
+    /* A new account needs the OAuth authentication widget */
+    var oauth_plugin = new TestOAuthPlugin (account);
+    assert (oauth_plugin.has_widget ());
+}
+
 void accountplugin_create_headless ()
 {
     /* Making warnings non-fatal is needed because at-spi2 emits a g_warning
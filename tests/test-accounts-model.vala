@@ -17,6 +17,61 @@
  *      David King <david.king@canonical.com>
  */
 
+[CCode (cname = "struct mallinfo", cheader_filename = "malloc.h", destroy_function = "", has_type_id = false)]
+struct MallocInfo
+{
+    public int uordblks;
+}
+
+[CCode (cname = "mallinfo", cheader_filename = "malloc.h")]
+extern MallocInfo get_malloc_info ();
+
+/**
+ * In-process replacement for the webcredentials indicator, recording the
+ * calls made to it.
+ */
+class FakeWebcredentialsIndicator : Object, Cc.WebcredentialsIndicator
+{
+    private uint[] current_failures = {};
+    public uint[] reported = {};
+    public uint[] removed = {};
+    public uint clear_count = 0;
+
+    public uint[] failures
+    {
+        owned get
+        {
+            return current_failures;
+        }
+    }
+
+    public void set_failures (uint[] failures)
+    {
+        current_failures = failures;
+        notify_property ("failures");
+    }
+
+    public async void report_failure (uint account_id,
+                                      HashTable<string, Variant> notification)
+        throws IOError
+    {
+        reported += account_id;
+    }
+
+    public async void remove_failures (uint[] account_ids) throws IOError
+    {
+        foreach (var account_id in account_ids)
+        {
+            removed += account_id;
+        }
+    }
+
+    public async void clear_error_status () throws IOError
+    {
+        clear_count++;
+    }
+}
+
 int main (string[] args)
 {
     Gtk.test_init (ref args);
@@ -28,6 +83,33 @@ int main (string[] args)
     Test.add_func ("/credentials/accountsmodel/delete_account", accountsmodel_delete_account);
     */
 
+    Test.add_func ("/credentials/accountsmodel/coalesce_updates",
+                   accountsmodel_coalesce_updates);
+    Test.add_func ("/credentials/accountsmodel/subscriptions",
+                   accountsmodel_subscriptions);
+    Test.add_func ("/credentials/accountsmodel/sort_order",
+                   accountsmodel_sort_order);
+    Test.add_func ("/credentials/accountsmodel/failures_delta",
+                   accountsmodel_failures_delta);
+    Test.add_func ("/credentials/accountsmodel/provider_data",
+                   accountsmodel_provider_data);
+    Test.add_func ("/credentials/indicatorclient/queue",
+                   indicatorclient_queue);
+    Test.add_func ("/credentials/translucenticoncache/lookup",
+                   translucenticoncache_lookup);
+
+    if (Test.perf ())
+    {
+        Test.add_func ("/credentials/accountsmodel/update_failures/perf",
+                       accountsmodel_update_failures_perf);
+        Test.add_func ("/credentials/accountsmodel/progressive/perf",
+                       accountsmodel_progressive_perf);
+        Test.add_func ("/credentials/accountsmodel/memory/perf",
+                       accountsmodel_memory_perf);
+        Test.add_func ("/credentials/accountsmodel/sort_order/perf",
+                       accountsmodel_sort_order_perf);
+    }
+
     Test.run ();
 
     return Posix.EXIT_SUCCESS;
@@ -125,3 +207,572 @@ void accountsmodel_delete_account ()
         assert_not_reached ();
     }
 }
+
+void run_pending_idles ()
+{
+    while (MainContext.default ().iteration (false));
+}
+
+void accountsmodel_coalesce_updates ()
+{
+    var accounts_model = new Cc.Credentials.AccountsModel ();
+    var account = accounts_model.manager.create_account ("MyProvider");
+
+    try
+    {
+        account.store_blocking ();
+    }
+    catch (Error error)
+    {
+        assert_not_reached ();
+    }
+    run_pending_idles ();
+
+    var rows_changed = 0;
+    accounts_model.row_changed.connect (() => { rows_changed++; });
+    var received = accounts_model.updates_received;
+    var applied = accounts_model.updates_applied;
+
+    // A storm of updates without any actual change.
+    for (var i = 0; i < 5; i++)
+    {
+        accounts_model.queue_account_update (account.id);
+    }
+    run_pending_idles ();
+    assert (accounts_model.updates_received == received + 5);
+    assert (accounts_model.updates_applied == applied);
+    assert (rows_changed == 0);
+
+    // Updates merged within one main loop iteration are applied once.
+    account.set_display_name ("Coalesced");
+    accounts_model.queue_account_update (account.id);
+    accounts_model.queue_account_update (account.id);
+    run_pending_idles ();
+    assert (accounts_model.updates_applied == applied + 1);
+    assert (rows_changed == 1);
+
+    account.delete ();
+
+    try
+    {
+        account.store_blocking ();
+    }
+    catch (Error error)
+    {
+        assert_not_reached ();
+    }
+}
+
+void accountsmodel_subscriptions ()
+{
+    var accounts_model = new Cc.Credentials.AccountsModel ();
+    var subscriptions = accounts_model.subscription_count;
+    var account = accounts_model.manager.create_account ("MyProvider");
+
+    try
+    {
+        account.store_blocking ();
+    }
+    catch (Error error)
+    {
+        assert_not_reached ();
+    }
+    run_pending_idles ();
+    assert (accounts_model.subscription_count == subscriptions + 1);
+
+    // Refreshing the row must not connect the handlers again.
+    for (var i = 0; i < 10; i++)
+    {
+        account.set_display_name ("Subscribed %d".printf (i));
+        accounts_model.queue_account_update (account.id);
+        run_pending_idles ();
+    }
+    assert (accounts_model.subscription_count == subscriptions + 1);
+
+    account.delete ();
+
+    try
+    {
+        account.store_blocking ();
+    }
+    catch (Error error)
+    {
+        assert_not_reached ();
+    }
+    run_pending_idles ();
+    assert (accounts_model.subscription_count == subscriptions);
+}
+
+void indicatorclient_queue ()
+{
+    var client = new Cc.WebcredentialsIndicatorClient ();
+    var changes = 0;
+    client.failures_changed.connect (() => { changes++; });
+
+    // Calls made before the indicator is ready are queued, in order.
+    client.report_failure (3, new HashTable<string, Variant> (str_hash, str_equal));
+    client.remove_failures ({ 1, 2 });
+    client.clear_error_status ();
+    assert (!client.connected);
+    assert (client.pending_call_count == 3);
+    assert (client.failures.length == 0);
+
+    var indicator = new FakeWebcredentialsIndicator ();
+    indicator.set_failures ({ 3, 4 });
+    client.set_indicator (indicator);
+    run_pending_idles ();
+
+    assert (client.connected);
+    assert (client.pending_call_count == 0);
+    assert (indicator.reported.length == 1 && indicator.reported[0] == 3);
+    assert (indicator.removed.length == 2 && indicator.removed[1] == 2);
+    assert (indicator.clear_count == 1);
+
+    // The failures are cached, and changes are notified.
+    assert (changes == 1);
+    assert (client.failures.length == 2);
+    indicator.set_failures ({ 4 });
+    assert (changes == 2);
+    assert (client.failures.length == 1 && client.failures[0] == 4);
+
+    // Once connected, calls are sent straight away.
+    client.clear_error_status ();
+    run_pending_idles ();
+    assert (client.pending_call_count == 0);
+    assert (indicator.clear_count == 2);
+}
+
+void translucenticoncache_lookup ()
+{
+    var cache = new Cc.Credentials.TranslucentIconCache (new Gtk.IconTheme ());
+    var icon = new ThemedIcon ("credentials-add-account");
+
+    var pixbuf = cache.lookup (icon, 32, 1);
+    assert (cache.misses == 1);
+    assert (cache.hits == 0);
+
+    // The same pixbuf is shared for the same icon, size and scale.
+    assert (cache.lookup (icon, 32, 1) == pixbuf);
+    assert (cache.hits == 1);
+    cache.lookup (icon, 32, 2);
+    assert (cache.misses == 2);
+    assert (cache.hit_ratio > 0.3 && cache.hit_ratio < 0.4);
+
+    cache.flush ();
+    cache.lookup (icon, 32, 1);
+    assert (cache.misses == 3);
+}
+
+void add_synthetic_rows (Cc.Credentials.AccountsModel accounts_model,
+                         uint first_id,
+                         uint n_accounts)
+{
+    var provider = accounts_model.get_provider_data ("MyProvider");
+
+    for (uint i = 0; i < n_accounts; i++)
+    {
+        var row = Cc.Credentials.AccountsModel.AccountRow ();
+        row.account_id = first_id + i;
+        row.provider = provider;
+        row.display_name = "Synthetic account %u".printf (i);
+        row.enabled = true;
+        row.attention = false;
+        accounts_model.add_account_row (row);
+    }
+}
+
+bool row_needs_attention (Cc.Credentials.AccountsModel accounts_model,
+                          uint account_id)
+{
+    Gtk.TreeIter iter;
+    bool needs_attention;
+
+    assert (accounts_model.find_iter_for_account_id (account_id, out iter));
+    accounts_model.get (iter,
+                        Cc.Credentials.AccountsModel.ModelColumns.NEEDS_ATTENTION,
+                        out needs_attention,
+                        -1);
+    return needs_attention;
+}
+
+int row_position (Cc.Credentials.AccountsModel accounts_model,
+                  uint account_id)
+{
+    Gtk.TreeIter iter;
+
+    assert (accounts_model.find_iter_for_account_id (account_id, out iter));
+    return accounts_model.get_path (iter).get_indices ()[0];
+}
+
+void accountsmodel_sort_order ()
+{
+    var accounts_model = new Cc.Credentials.AccountsModel ();
+    // Keep clear of the IDs of any real accounts.
+    const uint first_id = 100000;
+    string[] names = { "Sortable charlie", "sortable Alice", "Sortable bob" };
+
+    var provider = accounts_model.get_provider_data ("MyProvider");
+    for (uint i = 0; i < names.length; i++)
+    {
+        var row = Cc.Credentials.AccountsModel.AccountRow ();
+        row.account_id = first_id + i;
+        row.provider = provider;
+        row.display_name = names[i];
+        row.enabled = true;
+        row.attention = false;
+        accounts_model.add_account_row (row);
+    }
+
+    var charlie = first_id;
+    var alice = first_id + 1;
+    var bob = first_id + 2;
+
+    // Iters persist across reorderings.
+    Gtk.TreeIter alice_iter;
+    assert (accounts_model.find_iter_for_account_id (alice, out alice_iter));
+
+    var reorders = 0;
+    accounts_model.rows_reordered.connect (() => { reorders++; });
+
+    accounts_model.sort_order = Cc.Credentials.AccountsModel.SortOrder.DISPLAY_NAME;
+    assert (reorders == 1);
+    assert (row_position (accounts_model, alice) < row_position (accounts_model, bob));
+    assert (row_position (accounts_model, bob) < row_position (accounts_model, charlie));
+    assert (accounts_model.get_path (alice_iter).get_indices ()[0]
+            == row_position (accounts_model, alice));
+
+    // A failing account moves to the top, and moves back once fixed.
+    accounts_model.sort_order = Cc.Credentials.AccountsModel.SortOrder.NEEDS_ATTENTION;
+    reorders = 0;
+    accounts_model.update_failures ({ bob });
+    assert (reorders == 1);
+    assert (row_position (accounts_model, bob) == 0);
+    accounts_model.update_failures (null);
+    assert (row_position (accounts_model, bob) > row_position (accounts_model, alice));
+
+    // The "Add account…" row stays last.
+    Gtk.TreeIter iter;
+    uint account_id;
+    var n_rows = accounts_model.iter_n_children (null);
+    assert (accounts_model.iter_nth_child (out iter, null, n_rows - 1));
+    accounts_model.get (iter,
+                        Cc.Credentials.AccountsModel.ModelColumns.ACCOUNT_ID,
+                        out account_id,
+                        -1);
+    assert (account_id == 0);
+
+    // Prefix lookups ignore case, and return the matches sorted by name.
+    var matches = accounts_model.find_accounts_by_prefix ("SORTABLE");
+    assert (matches.length == 3);
+    assert (matches[0] == alice && matches[1] == bob && matches[2] == charlie);
+    matches = accounts_model.find_accounts_by_prefix ("sortable b");
+    assert (matches.length == 1 && matches[0] == bob);
+    assert (accounts_model.find_accounts_by_prefix ("sortable d").length == 0);
+}
+
+void accountsmodel_provider_data ()
+{
+    var data_catalog = new Cc.Credentials.DataCatalog ();
+    var accounts_model = new Cc.Credentials.AccountsModel (false, data_catalog);
+    // Keep clear of the IDs of any real accounts.
+    const uint first_id = 100000;
+
+    // Accounts of uninstalled providers show the provider name.
+    var missing = accounts_model.get_provider_data ("NoSuchProvider");
+    assert (missing.display_name == "NoSuchProvider");
+    assert (missing.icon == null);
+
+    add_synthetic_rows (accounts_model, first_id, 2);
+    var provider = accounts_model.get_provider_data ("MyProvider");
+    assert (accounts_model.get_provider_data ("MyProvider") == provider);
+
+    var rows_changed = 0;
+    accounts_model.row_changed.connect (() => { rows_changed++; });
+
+    // The provider details are reloaded when the provider files change.
+    data_catalog.changed ();
+    var reloaded = accounts_model.get_provider_data ("MyProvider");
+    assert (reloaded != provider);
+    assert (reloaded.display_name == provider.display_name);
+    // Any stored accounts are updated too.
+    assert (rows_changed >= 2);
+}
+
+void accountsmodel_failures_delta ()
+{
+    var indicator = new FakeWebcredentialsIndicator ();
+    var client = new Cc.WebcredentialsIndicatorClient ();
+    client.set_indicator (indicator);
+    var previous_client = Cc.WebcredentialsIndicatorClient.set_default (client);
+
+    var accounts_model = new Cc.Credentials.AccountsModel ();
+    const uint n_accounts = 2000;
+    const uint n_changes = 5000;
+    // Keep clear of the IDs of any real accounts.
+    const uint first_id = 100000;
+
+    add_synthetic_rows (accounts_model, first_id, n_accounts);
+
+    var rows_changed = 0;
+    accounts_model.row_changed.connect (() => { rows_changed++; });
+
+    var failing = new bool[n_accounts];
+    var expected_changes = 0;
+    var random = new Rand.with_seed (42);
+    var timer = new Timer ();
+
+    for (uint change = 0; change < n_changes; change++)
+    {
+        // Flip the state of a few distinct accounts.
+        int32[] flipped = {};
+        var n_flips = random.int_range (1, 5);
+        while (flipped.length < n_flips)
+        {
+            var index = random.int_range (0, (int32) n_accounts);
+            if (!(index in flipped))
+            {
+                flipped += index;
+                failing[index] = !failing[index];
+            }
+        }
+        expected_changes += flipped.length;
+
+        /* The indicator reports the whole set each time, in no particular
+         * order, and possibly with duplicates. */
+        uint[] failures = {};
+        for (var i = (int) n_accounts - 1; i >= 0; i--)
+        {
+            if (failing[i])
+            {
+                failures += first_id + i;
+            }
+        }
+        if (failures.length > 0)
+        {
+            failures += failures[0];
+        }
+
+        indicator.set_failures (failures);
+    }
+
+    timer.stop ();
+
+    // Only the rows whose state flipped were touched.
+    assert (rows_changed == expected_changes);
+
+    for (uint i = 0; i < n_accounts; i++)
+    {
+        assert (row_needs_attention (accounts_model, first_id + i) == failing[i]);
+    }
+
+    Test.minimized_result (timer.elapsed (),
+                           "%u failure changes for %u accounts: %d row updates",
+                           n_changes, n_accounts, rows_changed);
+
+    Cc.WebcredentialsIndicatorClient.set_default (previous_client);
+}
+
+void accountsmodel_update_failures_perf ()
+{
+    var accounts_model = new Cc.Credentials.AccountsModel ();
+    const uint n_accounts = 10000;
+    // Keep clear of the IDs of any real accounts.
+    const uint first_id = 100000;
+
+    add_synthetic_rows (accounts_model, first_id, n_accounts);
+
+    // One account in ten is failing.
+    uint[] failures = {};
+    for (uint i = 0; i < n_accounts; i += 10)
+    {
+        failures += first_id + i;
+    }
+
+    var timer = new Timer ();
+    accounts_model.update_failures (failures);
+    timer.stop ();
+    var set_elapsed = timer.elapsed ();
+
+    assert (row_needs_attention (accounts_model, first_id + 10));
+    assert (!row_needs_attention (accounts_model, first_id + 11));
+
+    timer.start ();
+    accounts_model.update_failures (null);
+    timer.stop ();
+    var clear_elapsed = timer.elapsed ();
+
+    assert (!row_needs_attention (accounts_model, first_id + 10));
+
+    Test.minimized_result (set_elapsed + clear_elapsed,
+                           "Failure update for %u accounts: set %g s, clear %g s",
+                           n_accounts, set_elapsed, clear_elapsed);
+}
+
+void accountsmodel_progressive_perf ()
+{
+    var manager = new Ag.Manager ();
+    const int n_accounts = 200;
+    Ag.Account[] accounts = {};
+
+    for (var i = 0; i < n_accounts; i++)
+    {
+        var account = manager.create_account ("MyProvider");
+        account.set_display_name ("Account %d".printf (i));
+
+        try
+        {
+            account.store_blocking ();
+        }
+        catch (Error error)
+        {
+            assert_not_reached ();
+        }
+        accounts += account;
+    }
+
+    var timer = new Timer ();
+    var sync_model = new Cc.Credentials.AccountsModel ();
+    timer.stop ();
+    var sync_elapsed = timer.elapsed ();
+
+    // Time to first paint: only placeholder rows are created.
+    timer.start ();
+    var progressive_model = new Cc.Credentials.AccountsModel (true);
+    timer.stop ();
+    var progressive_elapsed = timer.elapsed ();
+
+    assert (progressive_model.iter_n_children (null) ==
+            sync_model.iter_n_children (null));
+
+    var main_loop = new MainLoop (null, false);
+    progressive_model.population_finished.connect (() => {
+        main_loop.quit ();
+    });
+    if (!progressive_model.populated)
+    {
+        main_loop.run ();
+    }
+
+    // Once populated, the models have the same contents.
+    Gtk.TreeIter sync_iter, progressive_iter;
+    assert (sync_model.get_iter_first (out sync_iter));
+    assert (progressive_model.get_iter_first (out progressive_iter));
+    do
+    {
+        string sync_description, progressive_description;
+        sync_model.get (sync_iter,
+                        Cc.Credentials.AccountsModel.ModelColumns.ACCOUNT_DESCRIPTION,
+                        out sync_description,
+                        -1);
+        progressive_model.get (progressive_iter,
+                               Cc.Credentials.AccountsModel.ModelColumns.ACCOUNT_DESCRIPTION,
+                               out progressive_description,
+                               -1);
+        assert (sync_description == progressive_description);
+    } while (sync_model.iter_next (ref sync_iter) &&
+             progressive_model.iter_next (ref progressive_iter));
+
+    Test.minimized_result (progressive_elapsed,
+                           "Model construction for %d accounts: %g s, %g s when progressive",
+                           n_accounts, sync_elapsed, progressive_elapsed);
+
+    foreach (var account in accounts)
+    {
+        account.delete ();
+
+        try
+        {
+            account.store_blocking ();
+        }
+        catch (Error error)
+        {
+            assert_not_reached ();
+        }
+    }
+}
+
+void accountsmodel_memory_perf ()
+{
+    const uint n_accounts = 10000;
+    const uint first_id = 100000;
+
+    // Create the shared data first, so that it is not accounted for below.
+    var accounts_model = new Cc.Credentials.AccountsModel ();
+    accounts_model.get_provider_data ("MyProvider");
+    var provider = accounts_model.manager.get_provider ("MyProvider");
+    var icon = new ThemedIcon (provider.get_icon_name ());
+    var pixbuf = Cc.Credentials.TranslucentIconCache.get_default ().lookup (icon, 32, 1);
+
+    var before = get_malloc_info ().uordblks;
+    add_synthetic_rows (accounts_model, first_id, n_accounts);
+    var model_bytes = get_malloc_info ().uordblks - before;
+
+    // The same rows in a Gtk.ListStore, as the model used to store them.
+    Type[] types = { typeof (uint), typeof (Ag.Account), typeof (Icon),
+                     typeof (Gdk.Pixbuf), typeof (string), typeof (bool),
+                     typeof (bool) };
+    var list_store = new Gtk.ListStore.newv (types);
+
+    before = get_malloc_info ().uordblks;
+    for (uint i = 0; i < n_accounts; i++)
+    {
+        var description = provider.get_display_name () + "\n"
+                          + "<small>Synthetic account %u</small>".printf (i);
+        list_store.insert_with_values (null, -1,
+                                       0, first_id + i,
+                                       2, icon,
+                                       3, pixbuf,
+                                       4, description,
+                                       5, true,
+                                       6, false,
+                                       -1);
+    }
+    var list_store_bytes = get_malloc_info ().uordblks - before;
+
+    var model_bytes_per_row = (double) model_bytes / n_accounts;
+    var list_store_bytes_per_row = (double) list_store_bytes / n_accounts;
+    Test.minimized_result (model_bytes_per_row,
+                           "Memory per row: %g bytes, %g bytes with Gtk.ListStore",
+                           model_bytes_per_row, list_store_bytes_per_row);
+}
+
+void accountsmodel_sort_order_perf ()
+{
+    var accounts_model = new Cc.Credentials.AccountsModel ();
+    const uint n_accounts = 10000;
+    // Keep clear of the IDs of any real accounts.
+    const uint first_id = 100000;
+
+    accounts_model.sort_order = Cc.Credentials.AccountsModel.SortOrder.NEEDS_ATTENTION;
+
+    var timer = new Timer ();
+    add_synthetic_rows (accounts_model, first_id, n_accounts);
+    timer.stop ();
+    var insert_elapsed = timer.elapsed ();
+
+    // Every failing account moves to the top of the list.
+    uint[] failures = {};
+    for (uint i = 0; i < n_accounts; i += 10)
+    {
+        failures += first_id + i;
+    }
+
+    timer.start ();
+    accounts_model.update_failures (failures);
+    timer.stop ();
+    var move_elapsed = timer.elapsed ();
+
+    assert (row_position (accounts_model, first_id + 10) < n_accounts / 10);
+
+    timer.start ();
+    var matches = accounts_model.find_accounts_by_prefix ("synthetic account 99");
+    timer.stop ();
+    var lookup_elapsed = timer.elapsed ();
+
+    // "Synthetic account 99" and "Synthetic account 990" to 999.
+    assert (matches.length == 11);
+
+    Test.minimized_result (insert_elapsed + move_elapsed,
+                           "Sorted model with %u accounts: insert %g s, move %g s, prefix lookup %g s",
+                           n_accounts, insert_elapsed, move_elapsed, lookup_elapsed);
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2012 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License version 3, as published 
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranties of 
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+public class TestPlugin : Ap.Plugin
+{
+    public TestPlugin (Ag.Account account)
+    {
+        Object (account: account);
+    }
+}
+
+/* Constructs test plugins instead of loading plugin modules. */
+public class FakePluginCache : Cc.Credentials.PluginCache
+{
+    public FakePluginCache (Ag.Manager manager, uint max_size)
+    {
+        base (manager, max_size);
+    }
+
+    internal override async Ap.Plugin? construct_plugin (Ag.Account account,
+                                                         Cancellable? cancellable)
+        throws Error
+    {
+        return new TestPlugin (account);
+    }
+}
+
+int main (string[] args)
+{
+    Gtk.test_init (ref args);
+
+    Test.add_func ("/credentials/plugincache/shared", plugincache_shared);
+
+    Test.run ();
+
+    return Posix.EXIT_SUCCESS;
+}
+
+Ap.Plugin? load_plugin (Cc.Credentials.PluginCache cache,
+                        Ag.Account account,
+                        bool shared)
+{
+    var main_loop = new MainLoop ();
+    var done = false;
+    Ap.Plugin? plugin = null;
+
+    AsyncReadyCallback callback = (obj, res) =>
+    {
+        try
+        {
+            plugin = shared ? cache.load_shared_async.end (res)
+                            : cache.load_fresh_async.end (res);
+        }
+        catch (Error error)
+        {
+            assert_not_reached ();
+        }
+
+        done = true;
+        main_loop.quit ();
+    };
+
+    if (shared)
+    {
+        cache.load_shared_async.begin (account, null, callback);
+    }
+    else
+    {
+        cache.load_fresh_async.begin (account, null, callback);
+    }
+
+    if (!done)
+    {
+        main_loop.run ();
+    }
+
+    return plugin;
+}
+
+/**
+ * Store the changes to an account, and wait until the account manager
+ * reports that the account was updated or deleted.
+ *
+ * @param manager the account manager of the account
+ * @param account the account to store
+ */
+void store_and_wait (Ag.Manager manager, Ag.Account account)
+{
+    var main_loop = new MainLoop ();
+    var account_id = account.id;
+    var reported = false;
+
+    var updated_handler = manager.account_updated.connect ((id) =>
+    {
+        if (id == account_id)
+        {
+            reported = true;
+            main_loop.quit ();
+        }
+    });
+    var deleted_handler = manager.account_deleted.connect ((id) =>
+    {
+        if (id == account_id)
+        {
+            reported = true;
+            main_loop.quit ();
+        }
+    });
+
+    try
+    {
+        account.store_blocking ();
+    }
+    catch (Error error)
+    {
+        assert_not_reached ();
+    }
+
+    if (!reported)
+    {
+        var timeout = Timeout.add_seconds (10, () =>
+        {
+            main_loop.quit ();
+            return false;
+        });
+        main_loop.run ();
+        if (reported)
+        {
+            Source.remove (timeout);
+        }
+    }
+
+    SignalHandler.disconnect (manager, updated_handler);
+    SignalHandler.disconnect (manager, deleted_handler);
+    assert (reported);
+}
+
+void plugincache_shared ()
+{
+    var manager = Cc.Credentials.DataCatalog.get_default ().manager;
+    var cache = new FakePluginCache (manager, 2);
+    var first_account = store_test_account (manager);
+    var second_account = store_test_account (manager);
+    var third_account = store_test_account (manager);
+
+    // Read-only users of an account share one plugin.
+    var plugin = load_plugin (cache, first_account, true);
+    assert (plugin != null);
+    for (var i = 0; i < 5; i++)
+    {
+        assert (load_plugin (cache, first_account, true) == plugin);
+    }
+    assert (cache.plugins_constructed == 1);
+    assert (cache.constructions_saved == 5);
+
+    // Interactive users get their own plugin.
+    var fresh_plugin = load_plugin (cache, first_account, false);
+    assert (fresh_plugin != plugin);
+    assert (cache.plugins_constructed == 2);
+    assert (load_plugin (cache, first_account, true) == plugin);
+
+    // Storing a change to the account evicts its plugin.
+    first_account.set_display_name ("Updated account");
+    store_and_wait (manager, first_account);
+    assert (load_plugin (cache, first_account, true) != plugin);
+    assert (cache.plugins_constructed == 3);
+
+    // The least recently used plugin is evicted.
+    load_plugin (cache, second_account, true);
+    load_plugin (cache, third_account, true);
+    assert (cache.plugins_constructed == 5);
+    load_plugin (cache, third_account, true);
+    load_plugin (cache, first_account, true);
+    assert (cache.plugins_constructed == 6);
+    assert (cache.constructions_saved == 7);
+
+    // Deleting the account evicts its plugin.
+    third_account.delete ();
+    store_and_wait (manager, third_account);
+    load_plugin (cache, third_account, true);
+    assert (cache.plugins_constructed == 7);
+}
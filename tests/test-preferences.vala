@@ -24,6 +24,8 @@ int main (string[] args)
     /* Skip until a mock webcredentials indicator is developed.
     Test.add_func ("/credentials/preferences/create", preferences_create);
     */
+    Test.add_func ("/credentials/preferences/shared_manager",
+                   preferences_shared_manager);
 
     Test.run ();
 
@@ -38,6 +40,48 @@ void preferences_create ()
     var preferences = Gtk.test_create_widget (typeof (Cc.Credentials.Preferences));
 }
 
+void preferences_shared_manager ()
+{
+    /* Prevent warnings from making the test fail. */
+    Test.log_set_fatal_handler (log_is_fatal);
+
+    // Instances are only counted with GOBJECT_DEBUG=instance-count.
+    if (!("instance-count" in (Environment.get_variable ("GOBJECT_DEBUG") ?? "")))
+    {
+        Test.skip ("GOBJECT_DEBUG=instance-count is not set");
+        return;
+    }
+
+    // Queue the calls to the webcredentials indicator rather than connecting.
+    var previous_client =
+        Cc.WebcredentialsIndicatorClient.set_default (new Cc.WebcredentialsIndicatorClient ());
+    var managers_before = typeof (Ag.Manager).get_instance_count ();
+
+    var preferences = Gtk.test_create_widget (typeof (Cc.Credentials.Preferences));
+    assert (preferences != null);
+
+    /* Every model and page of the panel uses the same Ag.Manager. Each
+     * Ag.Manager opens the accounts database once, when it is constructed,
+     * and nothing else in the panel opens it, so this also counts the
+     * database connections. */
+    assert (typeof (Ag.Manager).get_instance_count () == managers_before + 1);
+
+    var catalog = Cc.Credentials.DataCatalog.get_default ();
+    var accounts_model = new Cc.Credentials.AccountsModel ();
+    assert (accounts_model.manager == catalog.manager);
+    var applications_model = new Cc.Credentials.ApplicationsModel ();
+    var account_applications_model = new Cc.Credentials.AccountApplicationsModel ();
+    var providers_model = new Cc.Credentials.ProvidersModel ();
+    var providers_page = new Cc.Credentials.ProvidersPage ();
+    assert (typeof (Ag.Manager).get_instance_count () == managers_before + 1);
+
+    // The lists are cached.
+    assert (catalog.list_services () == catalog.list_services ());
+    assert (catalog.list_providers () == catalog.list_providers ());
+
+    Cc.WebcredentialsIndicatorClient.set_default (previous_client);
+}
+
 bool log_is_fatal (string? log_domain, LogLevelFlags log_level, string message)
 {
     return (log_level & (LogLevelFlags.LEVEL_CRITICAL |
@@ -22,6 +22,19 @@ int main (string[] args)
     Gtk.test_init (ref args);
 
     Test.add_func ("/credentials/providersmodel/create", providersmodel_create);
+    Test.add_func ("/credentials/providersmodel/catalog", providersmodel_catalog);
+    Test.add_func ("/credentials/providerscatalog/invalidate",
+                   providerscatalog_invalidate);
+    Test.add_func ("/credentials/providerscatalog/racy_stamps",
+                   providerscatalog_racy_stamps);
+    Test.add_func ("/credentials/providerranking/sort_key",
+                   providerranking_sort_key);
+    Test.add_func ("/credentials/providersmodel/apply_entries",
+                   providersmodel_apply_entries);
+    Test.add_func ("/credentials/datamonitor/debounce",
+                   datamonitor_debounce);
+    Test.add_func ("/credentials/providersmodel/application_rows",
+                   providersmodel_application_rows);
 
     Test.run ();
 
@@ -35,3 +48,316 @@ void providersmodel_create ()
 
     treeview.model = providers_model;
 }
+
+string make_test_dir ()
+{
+    try
+    {
+        return DirUtils.make_tmp ("test-providers-catalog-XXXXXX");
+    }
+    catch (FileError error)
+    {
+        assert_not_reached ();
+    }
+}
+
+void providersmodel_catalog ()
+{
+    var catalog_path = Path.build_filename (make_test_dir (), "catalog");
+
+    var cold_model = new Cc.Credentials.ProvidersModel.with_catalog (catalog_path);
+    assert (!cold_model.loaded_from_catalog);
+    assert (FileUtils.test (catalog_path, FileTest.EXISTS));
+
+    // The second model is built from the catalog, with the same rows.
+    var data_catalog = new Cc.Credentials.DataCatalog ();
+    var warm_model = new Cc.Credentials.ProvidersModel.with_catalog (catalog_path,
+                                                                     null,
+                                                                     data_catalog);
+    assert (warm_model.loaded_from_catalog);
+    assert (warm_model.iter_n_children (null) == cold_model.iter_n_children (null));
+
+    // The applications are listed from the catalog too.
+    var warm_applications = new Cc.Credentials.ApplicationsModel.with_providers_model (warm_model);
+    assert (data_catalog.services_listed_count == 0);
+
+    var cold_applications = new Cc.Credentials.ApplicationsModel (data_catalog);
+    assert (data_catalog.services_listed_count == 1);
+    assert (warm_applications.iter_n_children (null) == cold_applications.iter_n_children (null));
+}
+
+void backdate_directory (string path)
+{
+    // A catalog is not stored right after its directories were modified.
+    try
+    {
+        var modified = (uint64) (get_real_time () / TimeSpan.SECOND) - 10;
+        File.new_for_path (path).set_attribute_uint64 (FileAttribute.TIME_MODIFIED,
+                                                       modified,
+                                                       FileQueryInfoFlags.NONE);
+    }
+    catch (Error error)
+    {
+        assert_not_reached ();
+    }
+}
+
+Cc.Credentials.ProvidersCatalog.ApplicationEntry make_application_entry (string name,
+                                                                        string description)
+{
+    var application = Cc.Credentials.ProvidersCatalog.ApplicationEntry ();
+    application.name = name;
+    application.description = description;
+
+    return application;
+}
+
+void providerscatalog_invalidate ()
+{
+    var test_dir = make_test_dir ();
+    var providers_dir = Path.build_filename (test_dir, "providers");
+    DirUtils.create (providers_dir, 0755);
+    Environment.set_variable ("AG_PROVIDERS", providers_dir, true);
+
+    backdate_directory (providers_dir);
+
+    Cc.Credentials.ProvidersCatalog.ApplicationEntry[] applications;
+    var catalog = new Cc.Credentials.ProvidersCatalog (Path.build_filename (test_dir, "catalog"));
+    assert (catalog.load (out applications) == null);
+
+    var entry = Cc.Credentials.ProvidersCatalog.Entry ();
+    entry.application_name = "all";
+    entry.provider_name = "MyProvider";
+    entry.provider_icon = "my-provider";
+    assert (catalog.save ({ entry },
+                          { make_application_entry ("Gwibber", "Gwibber") },
+                          Cc.Credentials.ProvidersCatalog.get_stamps ()));
+
+    var entries = catalog.load (out applications);
+    assert (entries != null);
+    assert (entries.length == 1);
+    assert (entries[0].provider_name == "MyProvider");
+    assert (entries[0].application_icon == "");
+    assert (applications.length == 1);
+    assert (applications[0].name == "Gwibber");
+
+    // Installing a provider file makes the catalog outdated.
+    try
+    {
+        FileUtils.set_contents (Path.build_filename (providers_dir,
+                                                     "new.provider"),
+                                "<provider/>");
+    }
+    catch (FileError error)
+    {
+        assert_not_reached ();
+    }
+    assert (catalog.load (out applications) == null);
+
+    Environment.unset_variable ("AG_PROVIDERS");
+}
+
+void providerscatalog_racy_stamps ()
+{
+    var test_dir = make_test_dir ();
+    var providers_dir = Path.build_filename (test_dir, "providers");
+    DirUtils.create (providers_dir, 0755);
+    Environment.set_variable ("AG_PROVIDERS", providers_dir, true);
+
+    var catalog_path = Path.build_filename (test_dir, "catalog");
+    var catalog = new Cc.Credentials.ProvidersCatalog (catalog_path);
+
+    /* The directory was just created, so a change within the same tick
+     * would not be noticed. */
+    assert (!catalog.save ({ make_entry ("all", "facebook", "Facebook") }, {},
+                           Cc.Credentials.ProvidersCatalog.get_stamps ()));
+    assert (!FileUtils.test (catalog_path, FileTest.EXISTS));
+
+    backdate_directory (providers_dir);
+    assert (catalog.save ({ make_entry ("all", "facebook", "Facebook") }, {},
+                          Cc.Credentials.ProvidersCatalog.get_stamps ()));
+    assert (FileUtils.test (catalog_path, FileTest.EXISTS));
+
+    Environment.unset_variable ("AG_PROVIDERS");
+}
+
+void providerranking_sort_key ()
+{
+    var test_dir = make_test_dir ();
+    var config_path = Path.build_filename (test_dir, "provider-ranking.conf");
+    var usage_path = Path.build_filename (test_dir, "provider-usage");
+
+    try
+    {
+        FileUtils.set_contents (config_path,
+                                "[Ranking]\n"
+                                + "all=facebook;google;\n"
+                                + "empathy=salut;google;\n");
+    }
+    catch (FileError error)
+    {
+        assert_not_reached ();
+    }
+
+    var ranking = new Cc.Credentials.ProviderRanking (config_path, usage_path);
+
+    // Configured providers come first, in order.
+    assert (ranking.get_sort_key ("all", "facebook") < ranking.get_sort_key ("all", "google"));
+    assert (ranking.get_sort_key ("all", "google") < ranking.get_sort_key ("all", "twitter"));
+    assert (ranking.get_sort_key ("empathy", "salut") < ranking.get_sort_key ("empathy", "google"));
+    assert (ranking.get_sort_key ("empathy", "facebook") == 0);
+    // Applications without their own ranking use the default one.
+    assert (ranking.get_sort_key ("shotwell", "facebook") == ranking.get_sort_key ("all", "facebook"));
+
+    // A chosen provider is boosted above the configured ones.
+    ranking.record_usage ("twitter");
+    assert (ranking.get_usage ("twitter") == 1);
+    assert (ranking.get_sort_key ("all", "twitter") < ranking.get_sort_key ("all", "facebook"));
+
+    // The usage counts are stored.
+    var reloaded = new Cc.Credentials.ProviderRanking (config_path, usage_path);
+    assert (reloaded.get_usage ("twitter") == 1);
+    assert (reloaded.get_sort_key ("all", "twitter") == ranking.get_sort_key ("all", "twitter"));
+}
+
+Cc.Credentials.ProvidersCatalog.Entry make_entry (string application_name,
+                                                  string provider_name,
+                                                  string description)
+{
+    var entry = Cc.Credentials.ProvidersCatalog.Entry ();
+    entry.application_name = application_name;
+    entry.application_icon = "";
+    entry.application_description = "";
+    entry.provider_name = provider_name;
+    entry.provider_icon = "";
+    entry.provider_description = description;
+    entry.tooltip = "";
+
+    return entry;
+}
+
+void providersmodel_apply_entries ()
+{
+    var catalog_path = Path.build_filename (make_test_dir (), "catalog");
+    var model = new Cc.Credentials.ProvidersModel.with_catalog (catalog_path);
+
+    model.apply_entries ({ make_entry ("all", "facebook", "Facebook"),
+                           make_entry ("all", "google", "Google"),
+                           make_entry ("empathy", "google", "Google") });
+    assert (model.iter_n_children (null) == 3);
+
+    var inserted = 0;
+    var deleted = 0;
+    var changed = 0;
+    model.row_inserted.connect (() => { inserted++; });
+    model.row_deleted.connect (() => { deleted++; });
+    model.row_changed.connect (() => { changed++; });
+
+    // Reapplying the same rows touches nothing.
+    model.apply_entries ({ make_entry ("all", "facebook", "Facebook"),
+                           make_entry ("all", "google", "Google"),
+                           make_entry ("empathy", "google", "Google") });
+    assert (inserted == 0 && deleted == 0 && changed == 0);
+
+    // Only the added and removed rows are inserted and deleted.
+    model.apply_entries ({ make_entry ("all", "facebook", "Facebook"),
+                           make_entry ("all", "twitter", "Twitter"),
+                           make_entry ("empathy", "google", "Google") });
+    assert (model.iter_n_children (null) == 3);
+    assert (deleted == 1);
+    assert (inserted == 1);
+
+    // Changed details update the row in place.
+    deleted = 0;
+    inserted = 0;
+    model.apply_entries ({ make_entry ("all", "facebook", "Facebook Chat"),
+                           make_entry ("all", "twitter", "Twitter"),
+                           make_entry ("empathy", "google", "Google") });
+    assert (deleted == 0 && inserted == 0);
+    assert (changed > 0);
+}
+
+void datamonitor_debounce ()
+{
+    var test_dir = make_test_dir ();
+    var monitor = new Cc.Credentials.DataMonitor ({ test_dir }, 100);
+    var main_loop = new MainLoop ();
+    monitor.changed.connect (() => { main_loop.quit (); });
+
+    // Installing a package creates several files in a row.
+    try
+    {
+        for (var i = 0; i < 5; i++)
+        {
+            FileUtils.set_contents (Path.build_filename (test_dir,
+                                                         "provider%d.provider".printf (i)),
+                                    "<provider/>");
+        }
+    }
+    catch (FileError error)
+    {
+        assert_not_reached ();
+    }
+
+    Timeout.add_seconds (10, () =>
+    {
+        main_loop.quit ();
+        return false;
+    });
+    main_loop.run ();
+
+    assert (monitor.events_received >= 5);
+    assert (monitor.batches_emitted == 1);
+}
+
+int count_application_rows (Cc.Credentials.ProvidersModel model,
+                            Cc.Credentials.ProvidersModel.ApplicationRows rows)
+{
+    var count = 0;
+
+    Gtk.TreeIter iter;
+    if (model.get_iter_first (out iter))
+    {
+        do
+        {
+            if (model.row_in_application (iter, rows))
+            {
+                count++;
+            }
+        } while (model.iter_next (ref iter));
+    }
+
+    return count;
+}
+
+void providersmodel_application_rows ()
+{
+    var catalog_path = Path.build_filename (make_test_dir (), "catalog");
+    var model = new Cc.Credentials.ProvidersModel.with_catalog (catalog_path);
+
+    model.apply_entries ({ make_entry ("all", "facebook", "Facebook"),
+                           make_entry ("all", "google", "Google"),
+                           make_entry ("empathy", "google", "Google"),
+                           make_entry ("empathy", "salut", "Salut") });
+
+    var all_rows = model.get_application_rows ("all");
+    var empathy_rows = model.get_application_rows ("empathy");
+    var shotwell_rows = model.get_application_rows ("shotwell");
+    assert (all_rows.count == 2);
+    assert (empathy_rows.count == 2);
+    assert (shotwell_rows.count == 0);
+    assert (count_application_rows (model, all_rows) == 2);
+    assert (count_application_rows (model, empathy_rows) == 2);
+    assert (count_application_rows (model, shotwell_rows) == 0);
+
+    // The sets follow the rows which are added and removed.
+    model.apply_entries ({ make_entry ("all", "facebook", "Facebook"),
+                           make_entry ("empathy", "google", "Google"),
+                           make_entry ("shotwell", "flickr", "Flickr") });
+    assert (all_rows.count == 1);
+    assert (empathy_rows.count == 1);
+    assert (shotwell_rows.count == 1);
+    assert (count_application_rows (model, all_rows) == 1);
+    assert (count_application_rows (model, empathy_rows) == 1);
+    assert (count_application_rows (model, shotwell_rows) == 1);
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2012 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it 
+ * under the terms of the GNU General Public License version 3, as published 
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranties of 
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along 
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Helpers shared by the test programs. */
+
+/**
+ * Create and store an account of the test provider.
+ *
+ * @param manager the account manager to create the account with
+ * @return the stored account
+ */
+Ag.Account store_test_account (Ag.Manager manager)
+{
+    var account = manager.create_account ("MyProvider");
+
+    try
+    {
+        account.store_blocking ();
+    }
+    catch (Error err)
+    {
+        error ("Failed to store new account: %s", err.message);
+    }
+
+    return account;
+}
@@ -18,14 +18,151 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <libaccounts-glib/ag-account.h>
 #include <libaccounts-glib/ag-manager.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Change when the way that the fingerprint is computed changes. */
+#define FINGERPRINT_VERSION "update-accounts fingerprint 1"
+
+static gboolean force = FALSE;
+static gboolean batch = FALSE;
+
+static GOptionEntry option_entries[] = {
+    { "force", 'f', 0, G_OPTION_ARG_NONE, &force,
+      "Check the accounts even if no service or provider changed", NULL },
+    { "batch", 'b', 0, G_OPTION_ARG_NONE, &batch,
+      "Check all the accounts before storing any, and print statistics", NULL },
+    { NULL }
+};
+
+/* Add the modification time of @path to the fingerprint. Packages install
+ * data files by renaming them into place, which updates the modification
+ * time of the directory. */
+static void
+add_directory_stamp (GChecksum *checksum, const gchar *path, time_t *max_mtime)
+{
+    GStatBuf file_stat;
+    gchar *stamp;
+
+    if (g_stat (path, &file_stat) == 0)
+    {
+        stamp = g_strdup_printf ("%s %" G_GINT64_FORMAT "\n",
+                                 path, (gint64)file_stat.st_mtime);
+        if (file_stat.st_mtime > *max_mtime)
+            *max_mtime = file_stat.st_mtime;
+    }
+    else
+    {
+        /* The directory does not exist (yet). */
+        stamp = g_strdup_printf ("%s -1\n", path);
+    }
+
+    g_checksum_update (checksum, (const guchar *)stamp, strlen (stamp));
+    g_free (stamp);
+}
+
+/* Add the directories of one type of libaccounts data files to the
+ * fingerprint, looking them up the same way as libaccounts-glib. */
+static void
+add_data_dir_stamps (GChecksum *checksum, const gchar *env_var,
+                     const gchar *subdir, time_t *max_mtime)
+{
+    const gchar *env_dir;
+    const gchar * const *data_dirs;
+    gchar *path;
+
+    env_dir = g_getenv (env_var);
+    if (env_dir != NULL)
+    {
+        add_directory_stamp (checksum, env_dir, max_mtime);
+        return;
+    }
+
+    path = g_build_filename (g_get_user_data_dir (), "accounts", subdir, NULL);
+    add_directory_stamp (checksum, path, max_mtime);
+    g_free (path);
+
+    for (data_dirs = g_get_system_data_dirs (); *data_dirs != NULL; data_dirs++)
+    {
+        path = g_build_filename (*data_dirs, "accounts", subdir, NULL);
+        add_directory_stamp (checksum, path, max_mtime);
+        g_free (path);
+    }
+}
+
+/* Compute the fingerprint of the installed services and providers. If one of
+ * the directories was modified within the current second, a change made
+ * later in the same second would not change the fingerprint, so @racy is set
+ * and the fingerprint must not be stored. */
+static gchar *
+compute_fingerprint (gboolean *racy)
+{
+    GChecksum *checksum;
+    time_t max_mtime = 0;
+    gchar *fingerprint;
+
+    checksum = g_checksum_new (G_CHECKSUM_SHA1);
+    g_checksum_update (checksum, (const guchar *)FINGERPRINT_VERSION,
+                       strlen (FINGERPRINT_VERSION));
+    add_data_dir_stamps (checksum, "AG_SERVICES", "services", &max_mtime);
+    add_data_dir_stamps (checksum, "AG_PROVIDERS", "providers", &max_mtime);
+
+    fingerprint = g_strdup (g_checksum_get_string (checksum));
+    g_checksum_free (checksum);
+
+    *racy = max_mtime >= time (NULL);
+    return fingerprint;
+}
+
+/* Get the path of the fingerprint stored after the last successful run. */
+static gchar *
+get_stamp_path (void)
+{
+    return g_build_filename (g_get_user_cache_dir (),
+                             "credentials-control-center",
+                             "update-accounts-stamp", NULL);
+}
+
+static gboolean
+stamp_matches (const gchar *stamp_path, const gchar *fingerprint)
+{
+    gchar *contents;
+    gboolean matches;
+
+    if (!g_file_get_contents (stamp_path, &contents, NULL, NULL))
+        return FALSE;
+
+    matches = strcmp (g_strstrip (contents), fingerprint) == 0;
+    g_free (contents);
+    return matches;
+}
 
-/* Check if new services have been installed for this account and, if so,
- * enable them. */
 static void
-update_account (AgAccount *account, GError **error)
+write_stamp (const gchar *stamp_path, const gchar *fingerprint)
+{
+    GError *error = NULL;
+    gchar *stamp_dir;
+
+    stamp_dir = g_path_get_dirname (stamp_path);
+    g_mkdir_with_parents (stamp_dir, 0755);
+    g_free (stamp_dir);
+
+    if (!g_file_set_contents (stamp_path, fingerprint, -1, &error))
+    {
+        g_warning ("Could not write %s: %s", stamp_path, error->message);
+        g_clear_error (&error);
+    }
+}
+
+/* Check if new services have been installed for this account and, if so,
+ * enable them, without storing the account. Returns whether the account
+ * changed. */
+static gboolean
+enable_new_services (AgAccount *account)
 {
     GList *service_list, *iter;
     gboolean account_changed = FALSE;
@@ -49,23 +186,69 @@ update_account (AgAccount *account, GError **error)
             account_changed = TRUE;
         }
     }
+    ag_service_list_free (service_list);
 
-    if (account_changed)
-    {
-        ag_account_store_blocking (account, error);
-    }
+    return account_changed;
+}
+
+/* Print the statistics of a batch run, one "key=value" pair per line. */
+static void
+print_statistics (guint accounts_scanned, guint accounts_changed,
+                  gint64 start_time)
+{
+    g_print ("accounts-scanned=%u\n", accounts_scanned);
+    g_print ("accounts-changed=%u\n", accounts_changed);
+    g_print ("elapsed-us=%" G_GINT64_FORMAT "\n",
+             g_get_monotonic_time () - start_time);
 }
 
 int
 main (int argc, char **argv)
 {
+    GOptionContext *context;
+    GError *option_error = NULL;
     AgManager *manager;
     GList *account_list, *iter;
+    gchar *stamp_path, *fingerprint;
+    gboolean racy;
+    gboolean all_updated = TRUE;
+    GList *changed_accounts = NULL;
+    guint accounts_scanned = 0, accounts_changed = 0;
+    gint64 start_time;
 
 #if !GLIB_CHECK_VERSION (2, 35, 1)
     g_type_init ();
 #endif
 
+    context = g_option_context_new (NULL);
+    g_option_context_set_summary (context,
+        "Enable the newly installed services on the existing accounts.");
+    g_option_context_add_main_entries (context, option_entries, NULL);
+    if (!g_option_context_parse (context, &argc, &argv, &option_error))
+    {
+        g_printerr ("%s\n", option_error->message);
+        g_clear_error (&option_error);
+        g_option_context_free (context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free (context);
+
+    start_time = g_get_monotonic_time ();
+
+    /* The panel runs this tool every time that it is opened, but services
+     * are only installed by package upgrades: unless they changed since the
+     * last successful run, don't even open the accounts database. */
+    stamp_path = get_stamp_path ();
+    fingerprint = compute_fingerprint (&racy);
+    if (!force && stamp_matches (stamp_path, fingerprint))
+    {
+        if (batch)
+            print_statistics (accounts_scanned, accounts_changed, start_time);
+        g_free (fingerprint);
+        g_free (stamp_path);
+        return EXIT_SUCCESS;
+    }
+
     manager = ag_manager_new ();
     account_list = ag_manager_list (manager);
 
@@ -82,21 +265,74 @@ main (int argc, char **argv)
             g_warning ("Could not load account %d: %s",
                        account_id, error->message);
             g_clear_error (&error);
+            all_updated = FALSE;
             continue;
         }
 
-        update_account (account, &error);
+        accounts_scanned++;
+
+        if (!enable_new_services (account))
+        {
+            g_object_unref (account);
+            continue;
+        }
+
+        if (batch)
+        {
+            /* Stored below, once all the accounts have been checked. */
+            changed_accounts = g_list_prepend (changed_accounts, account);
+            continue;
+        }
+
+        ag_account_store_blocking (account, &error);
+        g_object_unref (account);
         if (G_UNLIKELY (error != NULL))
         {
             g_warning ("Could not update account %d: %s",
                        account_id, error->message);
             g_clear_error (&error);
+            all_updated = FALSE;
+            continue;
+        }
+        accounts_changed++;
+    }
+
+    /* libaccounts-glib has no transaction spanning several accounts, and
+     * every store emits its own change notification; in batch mode the
+     * changes are at least computed before the first store, so that the
+     * stores happen back to back and the running panels see them as a
+     * single burst. */
+    changed_accounts = g_list_reverse (changed_accounts);
+    for (iter = changed_accounts; iter != NULL; iter = g_list_next (iter))
+    {
+        AgAccount *account = iter->data;
+        GError *error = NULL;
+
+        ag_account_store_blocking (account, &error);
+        if (G_UNLIKELY (error != NULL))
+        {
+            g_warning ("Could not update account %d: %s",
+                       account->id, error->message);
+            g_clear_error (&error);
+            all_updated = FALSE;
             continue;
         }
+        accounts_changed++;
     }
+    g_list_free_full (changed_accounts, g_object_unref);
 
     ag_manager_list_free (account_list);
     g_object_unref (manager);
 
+    /* Accounts which failed are retried on the next run. */
+    if (all_updated && !racy)
+        write_stamp (stamp_path, fingerprint);
+
+    if (batch)
+        print_statistics (accounts_scanned, accounts_changed, start_time);
+
+    g_free (fingerprint);
+    g_free (stamp_path);
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2012 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gmodule.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Keep this in sync with libaccount-plugin/client.c */
+#define PLUGIN_MANIFEST_HEADER "libaccount-plugin manifest 1"
+#define PLUGIN_MANIFEST_SUFFIX ".manifest"
+
+static gint
+compare_strings (gconstpointer a, gconstpointer b)
+{
+    return strcmp (*(const gchar **)a, *(const gchar **)b);
+}
+
+/* Write the manifest of the plugins installed in @plugin_dir, listing the
+ * plugin names one per line. The manifest is written next to the directory,
+ * so that writing it doesn't change the directory modification time. */
+static gboolean
+write_manifest (const gchar *plugin_dir, GError **error)
+{
+    const gchar prefix[] = "lib";
+    const gchar suffix[] = "." G_MODULE_SUFFIX;
+    GDir *dir;
+    const gchar *filename;
+    GPtrArray *names;
+    GString *contents;
+    gchar *manifest_path;
+    gboolean ok;
+    guint i;
+
+    manifest_path = g_strconcat (plugin_dir, PLUGIN_MANIFEST_SUFFIX, NULL);
+
+    dir = g_dir_open (plugin_dir, 0, error);
+    if (dir == NULL)
+    {
+        /* No plugins are installed: remove any stale manifest. */
+        if (g_error_matches (*error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        {
+            g_clear_error (error);
+            if (g_unlink (manifest_path) != 0 && errno != ENOENT)
+                g_warning ("Could not remove %s", manifest_path);
+            g_free (manifest_path);
+            return TRUE;
+        }
+        g_free (manifest_path);
+        return FALSE;
+    }
+
+    names = g_ptr_array_new_with_free_func (g_free);
+    while ((filename = g_dir_read_name (dir)) != NULL)
+    {
+        gssize length;
+
+        if (!g_str_has_prefix (filename, prefix) ||
+            !g_str_has_suffix (filename, suffix))
+            continue;
+
+        length = strlen (filename) - (sizeof (prefix) - 1) -
+            (sizeof (suffix) - 1);
+        if (length <= 0)
+            continue;
+
+        g_ptr_array_add (names,
+                         g_strndup (filename + sizeof (prefix) - 1, length));
+    }
+    g_dir_close (dir);
+
+    g_ptr_array_sort (names, compare_strings);
+
+    contents = g_string_new (PLUGIN_MANIFEST_HEADER "\n");
+    for (i = 0; i < names->len; i++)
+    {
+        g_string_append (contents, g_ptr_array_index (names, i));
+        g_string_append_c (contents, '\n');
+    }
+
+    ok = g_file_set_contents (manifest_path, contents->str, contents->len,
+                              error);
+
+    g_string_free (contents, TRUE);
+    g_ptr_array_unref (names);
+    g_free (manifest_path);
+    return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+    const gchar *default_dirs[] = {
+        LIBACCOUNT_PLUGIN_DIR "/providers",
+        LIBACCOUNT_PLUGIN_DIR "/applications",
+        NULL
+    };
+    const gchar **plugin_dirs;
+    int status = EXIT_SUCCESS;
+    int i;
+
+    /* The plugin directories can be given on the command line; by default,
+     * update the manifests for the system-wide plugin directories. */
+    plugin_dirs = argc > 1 ? (const gchar **)(argv + 1) : default_dirs;
+
+    for (i = 0; plugin_dirs[i] != NULL; i++)
+    {
+        GError *error = NULL;
+
+        if (!write_manifest (plugin_dirs[i], &error))
+        {
+            g_warning ("Could not update the manifest for %s: %s",
+                       plugin_dirs[i], error->message);
+            g_clear_error (&error);
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}